@@ -0,0 +1,462 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+
+using namespace std;
+
+// Shape of a generated program; every knob maps to a command line flag
+struct WorkloadShape {
+    int functions = 100;
+    int statements = 20;
+    int exprDepth = 2;
+    int nesting = 2;
+    int loopPercent = 20;
+    int identifierCount = 64;
+
+    string name() const {
+        return "fn=" + to_string(functions) + ",st=" + to_string(statements) + ",depth=" + to_string(exprDepth) +
+            ",nest=" + to_string(nesting) + ",loops=" + to_string(loopPercent) + ",ids=" + to_string(identifierCount);
+    }
+};
+
+// xorshift64*, so the same seed yields the same workload on every platform
+class Rng {
+private:
+    uint64_t state;
+
+public:
+    Rng(uint64_t seed) : state(seed ? seed : 1) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+
+    int below(int n) {
+        return n > 0 ? static_cast<int>(next() % n) : 0;
+    }
+};
+
+const vector<string> benchKeywords = { "Adadi", "Ashriyal", "Harf", "Math", "Mantiqi", "Agar", "Wagarna", "for", "while", "match" };
+const int literalCount = 16;
+
+// Emits tokens.txt in the lexer's "<index,category>" / "<symbol>" format
+class WorkloadWriter {
+private:
+    WorkloadShape shape;
+    Rng rng;
+    ostringstream out;
+    long long tokenCount = 0;
+
+    void sym(const string& s) {
+        out << '<' << s << "> ";
+        tokenCount++;
+    }
+
+    void keyword(const string& name) {
+        int index = find(benchKeywords.begin(), benchKeywords.end(), name) - benchKeywords.begin() + 1;
+        out << '<' << index << ",keyword> ";
+        tokenCount++;
+    }
+
+    void identifier(int index) {
+        out << '<' << index << ",identifier> ";
+        tokenCount++;
+    }
+
+    void variable() {
+        identifier(rng.below(shape.identifierCount) + 1);
+    }
+
+    void number() {
+        out << '<' << rng.below(literalCount) + 1 << ",number> ";
+        tokenCount++;
+    }
+
+    void operand() {
+        if (rng.below(3) == 0) number();
+        else variable();
+    }
+
+    void expression(int depth) {
+        static const char* ops[] = { "+", "-", "*", "/" };
+        operand();
+        if (depth <= 0) return;
+        sym(ops[rng.below(4)]);
+        sym("(");
+        expression(depth - 1);
+        sym(")");
+    }
+
+    void condition() {
+        static const char* ops[] = { "==", "!=", "<>" };
+        variable();
+        sym(ops[rng.below(3)]);
+        expression(shape.exprDepth > 0 ? shape.exprDepth - 1 : 0);
+    }
+
+    void assignment() {
+        variable();
+        sym(":=");
+        expression(shape.exprDepth);
+        sym("::");
+    }
+
+    void loop() {
+        if (rng.below(2) == 0) {
+            keyword("while");
+            sym("(");
+            condition();
+            sym(")");
+        }
+        else {
+            int counter = rng.below(shape.identifierCount) + 1;
+            keyword("for");
+            sym("(");
+            identifier(counter);
+            sym(":=");
+            number();
+            sym("::");
+            identifier(counter);
+            sym("<>");
+            operand();
+            sym("::");
+            identifier(counter);
+            sym(":=");
+            identifier(counter);
+            sym("+");
+            number();
+            sym(")");
+        }
+        assignment();
+    }
+
+    // Alternates nested open ifs with Agar ... Wagarna chains
+    void conditional() {
+        if (rng.below(2) == 0) {
+            for (int i = 0; i < shape.nesting; ++i) {
+                keyword("Agar");
+                sym("(");
+                condition();
+                sym(")");
+            }
+            assignment();
+        }
+        else {
+            for (int i = 0; i < shape.nesting; ++i) {
+                keyword("Agar");
+                sym("(");
+                condition();
+                sym(")");
+                keyword("match");
+                keyword("Wagarna");
+            }
+            keyword("match");
+        }
+    }
+
+    void statement() {
+        int roll = rng.below(100);
+        if (roll < shape.loopPercent) loop();
+        else if (shape.nesting > 0 && roll < shape.loopPercent + 20) conditional();
+        else if (roll >= 90) {
+            keyword(benchKeywords[rng.below(5)]);
+            variable();
+            sym("::");
+        }
+        else assignment();
+        out << '\n';
+    }
+
+    void function(int index) {
+        keyword(benchKeywords[rng.below(5)]);
+        identifier(shape.identifierCount + index + 1);
+        sym("(");
+        if (rng.below(2) == 0) {
+            keyword(benchKeywords[rng.below(5)]);
+            variable();
+        }
+        sym(")");
+        sym("{");
+        out << '\n';
+        for (int i = 0; i < shape.statements; ++i) {
+            statement();
+        }
+        sym("}");
+        out << '\n';
+    }
+
+public:
+    WorkloadWriter(const WorkloadShape& s, uint64_t seed) : shape(s), rng(seed) {}
+
+    long long write(const string& dir) {
+        for (int f = 0; f < shape.functions; ++f) {
+            function(f);
+        }
+
+        ofstream tokenFile(dir + "/tokens.txt");
+        tokenFile << out.str();
+
+        ofstream idFile(dir + "/identifiers.txt");
+        for (int i = 1; i <= shape.identifierCount; ++i) idFile << "v" << i << '\n';
+        for (int f = 1; f <= shape.functions; ++f) idFile << "fn" << f << '\n';
+
+        ofstream kwFile(dir + "/keywords.txt");
+        for (const auto& kw : benchKeywords) kwFile << kw << '\n';
+
+        ofstream litFile(dir + "/literals.txt");
+        for (int i = 0; i < literalCount; ++i) litFile << i << '\n';
+
+        return tokenCount;
+    }
+};
+
+// Pulls "wall_ms" for one phase out of a --perf JSON file; -1 when the phase is missing
+double phaseMillis(const string& json, const string& phase) {
+    size_t at = json.find("\"name\": \"" + phase + "\"");
+    if (at == string::npos) return -1;
+    at = json.find("\"wall_ms\": ", at);
+    if (at == string::npos) return -1;
+    return atof(json.c_str() + at + 11);
+}
+
+string readFile(const string& filename) {
+    ifstream file(filename);
+    stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+double median(vector<double> samples) {
+    if (samples.empty()) return 0;
+    sort(samples.begin(), samples.end());
+    size_t mid = samples.size() / 2;
+    return samples.size() % 2 ? samples[mid] : (samples[mid - 1] + samples[mid]) / 2;
+}
+
+struct Stage {
+    const char* name;
+    const char* perfFile;   // nullptr for stages timed by the benchmark itself
+    const char* phase;
+};
+
+const vector<Stage> stages = {
+    { "token load", "parser.json", "loadTokensFromFiles" },
+    { "parse", "parser.json", "Functions" },
+    { "tree write", "parser.json", "printParseTreeToFile" },
+    { "tree read", "tacgen.json", "buildTreeFromFile" },
+    { "TAC generation", "tacgen.json", "processNode" },
+    { "TAC write", "tacgen.json", "saveToFile" },
+    { "parser process", nullptr, nullptr },
+    { "tacgen process", nullptr, nullptr },
+};
+
+struct BenchOptions {
+    string parser;
+    string tacgen;
+    string dir = "bench_work";
+    string baseline;
+    string saveBaseline;
+    int runs = 5;
+    uint64_t seed = 12345;
+    bool sweep = false;
+};
+
+double runTimed(const string& command, bool& ok) {
+    auto begin = chrono::steady_clock::now();
+    ok = system(command.c_str()) == 0;
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+// Runs one workload shape and returns the median milliseconds per stage
+map<string, double> runCase(const WorkloadShape& shape, const BenchOptions& options) {
+    map<string, double> result;
+
+    auto begin = chrono::steady_clock::now();
+    long long tokenCount = WorkloadWriter(shape, options.seed).write(options.dir);
+    double generateMs = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    // system() goes through cmd.exe on Windows and /bin/sh elsewhere
+#ifdef _WIN32
+    string cd = "cd /d \"" + options.dir + "\" && ";
+    string quiet = " > NUL";
+#else
+    string cd = "cd \"" + options.dir + "\" && ";
+    string quiet = " > /dev/null";
+#endif
+    string parserCmd = cd + "\"" + options.parser + "\" --no-cache --perf parser.json" + quiet;
+    string tacgenCmd = cd + "\"" + options.tacgen + "\" --no-cache --perf tacgen.json" + quiet;
+
+    map<string, vector<double>> samples;
+    for (int run = -1; run < options.runs; ++run) {
+        // A program that exits without writing its perf file must not pass on an old one
+        error_code ignored;
+        filesystem::remove(options.dir + "/parser.json", ignored);
+        filesystem::remove(options.dir + "/tacgen.json", ignored);
+
+        bool ok;
+        double parserMs = runTimed(parserCmd, ok);
+        if (ok) {
+            double tacgenMs = runTimed(tacgenCmd, ok);
+            if (ok && run >= 0) {
+                samples["parser process"].push_back(parserMs);
+                samples["tacgen process"].push_back(tacgenMs);
+            }
+        }
+        if (!ok) {
+            cerr << "Stage failed for " << shape.name() << endl;
+            return result;
+        }
+        if (run < 0) continue;  // warm-up
+
+        map<string, string> perf = {
+            { "parser.json", readFile(options.dir + "/parser.json") },
+            { "tacgen.json", readFile(options.dir + "/tacgen.json") },
+        };
+        for (const auto& stage : stages) {
+            if (!stage.perfFile) continue;
+            double ms = phaseMillis(perf[stage.perfFile], stage.phase);
+            if (ms < 0) {
+                cerr << "Phase " << stage.phase << " missing from " << stage.perfFile << " for " << shape.name() << endl;
+                return map<string, double>();
+            }
+            samples[stage.name].push_back(ms);
+        }
+    }
+
+    cout << "\n== " << shape.name() << " (" << tokenCount << " tokens, generated in " << generateMs << " ms)\n";
+    for (const auto& stage : stages) {
+        result[stage.name] = median(samples[stage.name]);
+    }
+    return result;
+}
+
+map<string, double> loadBaseline(const string& filename) {
+    map<string, double> baseline;
+    ifstream file(filename);
+    string line;
+    if (!getline(file, line) || line != "bench-baseline 1") return baseline;
+
+    // "<case>\t<stage>\t<median ms>"
+    while (getline(file, line)) {
+        size_t a = line.find('\t');
+        size_t b = line.rfind('\t');
+        if (a == string::npos || a == b) continue;
+        baseline[line.substr(0, b)] = atof(line.c_str() + b + 1);
+    }
+    return baseline;
+}
+
+void printCase(const WorkloadShape& shape, const map<string, double>& result, const map<string, double>& baseline) {
+    for (const auto& stage : stages) {
+        auto it = result.find(stage.name);
+        if (it == result.end()) continue;
+
+        cout << "  " << stage.name << string(16 - min<size_t>(16, string(stage.name).size()), ' ') << it->second << " ms";
+        auto base = baseline.find(shape.name() + "\t" + stage.name);
+        if (base != baseline.end() && base->second > 0) {
+            double delta = (it->second - base->second) / base->second * 100;
+            cout << "  (" << (delta >= 0 ? "+" : "") << delta << "% vs baseline " << base->second << " ms)";
+        }
+        cout << '\n';
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    WorkloadShape shape;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--sweep") options.sweep = true;
+        else if (!hasValue) {
+            cerr << "Missing value for " << arg << endl;
+            return 1;
+        }
+        else if (arg == "--parser") options.parser = argv[++i];
+        else if (arg == "--tacgen") options.tacgen = argv[++i];
+        else if (arg == "--dir") options.dir = argv[++i];
+        else if (arg == "--baseline") options.baseline = argv[++i];
+        else if (arg == "--save-baseline") options.saveBaseline = argv[++i];
+        else if (arg == "--runs") options.runs = max(1, atoi(argv[++i]));
+        else if (arg == "--seed") options.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--functions") shape.functions = atoi(argv[++i]);
+        else if (arg == "--statements") shape.statements = atoi(argv[++i]);
+        else if (arg == "--depth") shape.exprDepth = atoi(argv[++i]);
+        else if (arg == "--nesting") shape.nesting = atoi(argv[++i]);
+        else if (arg == "--loops") shape.loopPercent = atoi(argv[++i]);
+        else if (arg == "--identifiers") shape.identifierCount = max(1, atoi(argv[++i]));
+        else {
+            cerr << "Unknown option " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (options.parser.empty() || options.tacgen.empty()) {
+        cerr << "Usage: " << argv[0] << " --parser <exe> --tacgen <exe> [--runs N] [--seed N] [--dir DIR]\n"
+            << "    [--functions N] [--statements N] [--depth N] [--nesting N] [--loops PERCENT] [--identifiers N]\n"
+            << "    [--sweep] [--baseline FILE] [--save-baseline FILE]" << endl;
+        return 1;
+    }
+
+    options.parser = filesystem::absolute(options.parser).string();
+    options.tacgen = filesystem::absolute(options.tacgen).string();
+    filesystem::create_directories(options.dir);
+
+    // The sweep scales input size and nesting depth around the given shape
+    vector<WorkloadShape> cases = { shape };
+    if (options.sweep) {
+        for (int scale : { 2, 4, 8 }) {
+            WorkloadShape bigger = shape;
+            bigger.functions *= scale;
+            cases.push_back(bigger);
+        }
+        for (int depth : { 1, 4, 8, 16 }) {
+            WorkloadShape deeper = shape;
+            deeper.exprDepth = depth;
+            deeper.nesting = depth;
+            cases.push_back(deeper);
+        }
+    }
+
+    map<string, double> baseline;
+    if (!options.baseline.empty()) baseline = loadBaseline(options.baseline);
+
+    cout << "Median of " << options.runs << " runs after one warm-up, seed " << options.seed << endl;
+
+    vector<pair<WorkloadShape, map<string, double>>> results;
+    for (const auto& c : cases) {
+        map<string, double> result = runCase(c, options);
+        if (result.empty()) return 1;
+        printCase(c, result, baseline);
+        results.push_back({ c, result });
+    }
+
+    if (!options.saveBaseline.empty()) {
+        ofstream out(options.saveBaseline);
+        if (!out.is_open()) {
+            cerr << "Unable to open " << options.saveBaseline << " for writing" << endl;
+            return 1;
+        }
+        out << "bench-baseline 1\n";
+        for (const auto& r : results) {
+            for (const auto& stage : stages) {
+                out << r.first.name() << '\t' << stage.name << '\t' << r.second.at(stage.name) << '\n';
+            }
+        }
+        cout << "\nBaseline saved to " << options.saveBaseline << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+// Phase instrumentation and hashing shared by the parser and the TAC generator.
+// Include from exactly one translation unit per program: it replaces the global operator new.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+// FNV-1a, used for cache fingerprints and symbol table hashing
+const uint64_t fnvOffset = 1469598103934665603ULL;
+const uint64_t fnvPrime = 1099511628211ULL;
+
+inline void fnvMix(uint64_t& hash, const std::string& s) {
+    for (unsigned char c : s) {
+        hash ^= c;
+        hash *= fnvPrime;
+    }
+}
+
+// Mixes 's' followed by a separator so that ("ab", "c") and ("a", "bc") differ
+inline void fnvMixField(uint64_t& hash, const std::string& s) {
+    fnvMix(hash, s);
+    hash ^= 0xff;
+    hash *= fnvPrime;
+}
+
+// Word-at-a-time FNV for fingerprinting large trees, eight bytes per multiply. The shift after
+// each multiply folds high bits back down, which byte-wise FNV gets from its many small steps.
+inline void fnvMixWord(uint64_t& hash, uint64_t word) {
+    hash = (hash ^ word) * fnvPrime;
+    hash ^= hash >> 29;
+}
+
+// The length goes into the last word so that ("ab", "c") and ("a", "bc") differ
+inline void fnvMixFieldWords(uint64_t& hash, const std::string& s) {
+    size_t i = 0;
+    for (; i + 8 <= s.size(); i += 8) {
+        uint64_t word;
+        memcpy(&word, s.data() + i, 8);
+        fnvMixWord(hash, word);
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, s.data() + i, s.size() - i);
+    fnvMixWord(hash, tail ^ (static_cast<uint64_t>(s.size()) << 56));
+}
+
+// Phase instrumentation, enabled by --perf <file> and/or --trace <file>
+struct PhaseRecord {
+    const char* name;
+    const char* unit;       // what 'items' counts
+    long long startNanos;
+    long long durationNanos;
+    long long items;
+    long long nodes;        // nodes allocated during the phase
+    long long bytes;        // bytes allocated during the phase
+    long long peakRssKb;    // process high-water mark at the end of the phase
+};
+
+bool perfEnabled = false;
+std::vector<PhaseRecord> phaseRecords;
+std::chrono::steady_clock::time_point perfEpoch;
+
+// Allocation counters are per thread so worker threads never contend on one cache line.
+// A worker returns its totals with threadAllocations(); the thread that joins it adds them
+// with addAllocations(). Phases are timed on the main thread and read its counters.
+thread_local long long nodesAllocated = 0;
+thread_local long long bytesAllocated = 0;
+
+struct AllocationCounts {
+    long long nodes;
+    long long bytes;
+};
+
+inline AllocationCounts threadAllocations() {
+    return { nodesAllocated, bytesAllocated };
+}
+
+inline void addAllocations(const AllocationCounts& counts) {
+    nodesAllocated += counts.nodes;
+    bytesAllocated += counts.bytes;
+}
+
+// Called from tree node constructors
+inline void countNode() {
+    if (perfEnabled) nodesAllocated++;
+}
+
+void* operator new(size_t size) {
+    if (perfEnabled) bytesAllocated += size;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// Kept out of line so GCC does not pair the inlined free() with a builtin new
+#ifdef __GNUC__
+#define PERF_NOINLINE __attribute__((noinline))
+#else
+#define PERF_NOINLINE
+#endif
+
+PERF_NOINLINE void operator delete(void* p) noexcept {
+    free(p);
+}
+
+PERF_NOINLINE void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+long long peakRssKb() {
+#ifdef __unix__
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+    return 0;
+}
+
+inline long long nanosSince(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+long long perfNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - perfEpoch).count();
+}
+
+// Records one phase from construction to destruction; a no-op when disabled
+class PhaseTimer {
+private:
+    PhaseRecord record;
+    bool active;
+
+public:
+    PhaseTimer(const char* name) : active(perfEnabled) {
+        if (!active) return;
+        record = { name, "items", perfNow(), 0, 0, nodesAllocated, bytesAllocated, 0 };
+    }
+
+    void setItems(long long count, const char* unit) {
+        record.items = count;
+        record.unit = unit;
+    }
+
+    ~PhaseTimer() {
+        if (!active) return;
+        record.durationNanos = perfNow() - record.startNanos;
+        record.nodes = nodesAllocated - record.nodes;
+        record.bytes = bytesAllocated - record.bytes;
+        record.peakRssKb = peakRssKb();
+        phaseRecords.push_back(record);
+    }
+};
+
+void writePerfJson(const std::string& filename, const char* program) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Unable to open " << filename << " for writing" << std::endl;
+        return;
+    }
+
+    // Fixed notation keeps microsecond resolution however long the run
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"program\": \"" << program << "\",\n  \"phases\": [";
+    for (size_t i = 0; i < phaseRecords.size(); ++i) {
+        const PhaseRecord& r = phaseRecords[i];
+        double seconds = r.durationNanos / 1e9;
+        out << (i ? "," : "") << "\n    { \"name\": \"" << r.name << "\""
+            << ", \"wall_ms\": " << r.durationNanos / 1e6
+            << ", \"items\": " << r.items
+            << ", \"unit\": \"" << r.unit << "\""
+            << ", \"items_per_sec\": " << (seconds > 0 ? r.items / seconds : 0.0)
+            << ", \"nodes_allocated\": " << r.nodes
+            << ", \"bytes_allocated\": " << r.bytes
+            << ", \"peak_rss_kb\": " << r.peakRssKb << " }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Chrome trace-event format, viewable in chrome://tracing or Perfetto
+void writeTraceJson(const std::string& filename, const char* program) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        std::cerr << "Unable to open " << filename << " for writing" << std::endl;
+        return;
+    }
+
+    // Timestamps are microseconds; fixed notation keeps nanosecond resolution however long the run
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"" << program << "\"}}";
+    for (const PhaseRecord& r : phaseRecords) {
+        out << ",\n  {\"name\": \"" << r.name << "\", \"cat\": \"" << program << "\", \"ph\": \"X\""
+            << ", \"ts\": " << r.startNanos / 1e3 << ", \"dur\": " << r.durationNanos / 1e3
+            << ", \"pid\": 1, \"tid\": 1, \"args\": {\"" << r.unit << "\": " << r.items
+            << ", \"nodes_allocated\": " << r.nodes << ", \"bytes_allocated\": " << r.bytes
+            << ", \"peak_rss_kb\": " << r.peakRssKb << "}}";
+    }
+    out << "\n]}\n";
+}
@@ -5,6 +5,13 @@
 #include <string>
 #include <fstream>
 #include <stack>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include "Perf.h"
 
 using namespace std;
 
@@ -19,7 +26,9 @@ struct ParseTreeNode {
     string value;
     vector<ParseTreeNode*> children;
 
-    ParseTreeNode(string val) : value(val) {}
+    ParseTreeNode(string val) : value(val) {
+        countNode();
+    }
 };
 
 vector<Token> tokens;
@@ -30,6 +39,27 @@ unordered_map<int, string> identifiers;
 unordered_map<int, string> keywords;
 unordered_map<int, string> literals;
 
+// Per-function parse cache, keyed by a hash of the function's token range. Loaded entries
+// point into the file as read; functions parsed this run are serialized into a second buffer.
+struct CachedFunction {
+    size_t offset;          // serialized subtree (see serializeTree) within its buffer
+    size_t length;
+    long long parseNanos;   // cost of parsing it when it was cached
+    bool fresh;             // in newParseCacheData rather than parseCacheData
+};
+
+const string parseCacheFile = "tree.cache";
+const string parseCacheVersion = "tree-cache 2";
+bool useParseCache = true;
+string parseCacheData;
+string newParseCacheData;
+unordered_map<uint64_t, CachedFunction> parseCache;
+unordered_map<uint64_t, CachedFunction> usedParseCache;
+int cacheHits = 0;
+int cacheMisses = 0;
+long long cacheAvoidedNanos = 0;    // parse time of the functions that were hits
+long long cacheOverheadNanos = 0;   // everything the cache itself costs, including file I/O
+
 Token peek() {
     return (current < tokens.size()) ? tokens[current] : Token(-1, "EOF");
 }
@@ -510,9 +540,164 @@ void Factor() {
     endNode();
 }
 
+// Returns one past the brace closing the function body starting at 'start', or -1
+int findFunctionEnd(int start) {
+    int count = static_cast<int>(tokens.size());
+    int i = start;
+    while (i < count && tokens[i].lexeme != "{") {
+        if (tokens[i].category == "EOF") return -1;
+        i++;
+    }
+
+    int depth = 0;
+    for (; i < count; ++i) {
+        if (tokens[i].category == "EOF") return -1;
+        if (tokens[i].lexeme == "{") depth++;
+        else if (tokens[i].lexeme == "}" && --depth == 0) return i + 1;
+    }
+    return -1;
+}
+
+// FNV-1a over the category and lexeme of every token in [begin, end)
+uint64_t fingerprintTokens(int begin, int end) {
+    uint64_t hash = fnvOffset;
+    for (int i = begin; i < end; ++i) {
+        fnvMixField(hash, tokens[i].category);
+        fnvMixField(hash, tokens[i].lexeme);
+    }
+    return hash;
+}
+
+// Pre-order dump, one "<childCount> <value>" line per node
+void serializeTree(ParseTreeNode* node, string& out) {
+    out += to_string(node->children.size());
+    out += ' ';
+    out += node->value;
+    out += '\n';
+    for (auto child : node->children) {
+        serializeTree(child, out);
+    }
+}
+
+// Rebuilds a subtree from serializeTree() output in [pos, end); nullptr if it is malformed
+ParseTreeNode* deserializeTree(const char*& pos, const char* end) {
+    if (pos == end || !isdigit(static_cast<unsigned char>(*pos))) return nullptr;
+    size_t childCount = 0;
+    while (pos < end && isdigit(static_cast<unsigned char>(*pos))) {
+        childCount = childCount * 10 + (*pos++ - '0');
+    }
+    if (pos == end || *pos++ != ' ') return nullptr;
+    const char* newline = static_cast<const char*>(memchr(pos, '\n', end - pos));
+    if (!newline) return nullptr;
+
+    ParseTreeNode* node = new ParseTreeNode(string(pos, newline));
+    pos = newline + 1;
+    node->children.reserve(childCount);
+    for (size_t i = 0; i < childCount; ++i) {
+        ParseTreeNode* child = deserializeTree(pos, end);
+        if (!child) return nullptr;
+        node->children.push_back(child);
+    }
+    return node;
+}
+
+// Reads the whole file once and indexes it; entries are "<key> <parse ns> <bytes>\n<tree>"
+void loadParseCache() {
+    auto begin = chrono::steady_clock::now();
+    ifstream file(parseCacheFile, ios::binary | ios::ate);
+    if (file.is_open()) {
+        parseCacheData.resize(file.tellg());
+        file.seekg(0);
+        file.read(&parseCacheData[0], parseCacheData.size());
+    }
+
+    const char* data = parseCacheData.data();
+    const char* end = data + parseCacheData.size();
+    size_t headerLength = parseCacheVersion.size();
+    if (parseCacheData.compare(0, headerLength, parseCacheVersion) != 0 || parseCacheData[headerLength] != '\n') {
+        parseCacheData.clear();
+        end = data;
+    }
+
+    const char* pos = data + headerLength + 1;
+    while (pos < end) {
+        char* next;
+        uint64_t key = strtoull(pos, &next, 16);
+        long long nanos = strtoll(next, &next, 10);
+        size_t length = strtoull(next, &next, 10);
+        if (next >= end || *next != '\n' || length > static_cast<size_t>(end - next - 1)) break;
+
+        size_t offset = next + 1 - data;
+        parseCache[key] = { offset, length, nanos, false };
+        pos = data + offset + length;
+    }
+    cacheOverheadNanos += nanosSince(begin);
+}
+
+// Rewrites the file only when this run parsed something new or stopped using an entry
+void saveParseCache() {
+    if (cacheMisses == 0 && usedParseCache.size() == parseCache.size()) return;
+
+    auto begin = chrono::steady_clock::now();
+    ofstream file(parseCacheFile, ios::binary);
+    if (!file.is_open()) {
+        cerr << "Unable to open " << parseCacheFile << " for writing" << endl;
+        return;
+    }
+
+    file << parseCacheVersion << '\n';
+    for (const auto& entry : usedParseCache) {
+        const CachedFunction& cached = entry.second;
+        const string& buffer = cached.fresh ? newParseCacheData : parseCacheData;
+        file << hex << entry.first << dec << ' ' << cached.parseNanos << ' ' << cached.length << '\n';
+        file.write(buffer.data() + cached.offset, cached.length);
+    }
+    file.close();
+    cacheOverheadNanos += nanosSince(begin);
+}
+
 void Functions() {
     while (peek().category != "EOF") {
+        if (!useParseCache) {
+            Function();
+            continue;
+        }
+
+        // Everything but Function() itself counts as cache overhead
+        int start = current;
+        auto begin = chrono::steady_clock::now();
+        int end = findFunctionEnd(start);
+        uint64_t key = end < 0 ? 0 : fingerprintTokens(start, end);
+        auto cached = end < 0 ? parseCache.end() : parseCache.find(key);
+        if (cached != parseCache.end()) {
+            const char* pos = parseCacheData.data() + cached->second.offset;
+            ParseTreeNode* node = deserializeTree(pos, pos + cached->second.length);
+            if (node) {
+                parseTreeStack.top()->children.push_back(node);
+                current = end;
+                cacheOverheadNanos += nanosSince(begin);
+                cacheAvoidedNanos += cached->second.parseNanos;
+                cacheHits++;
+                usedParseCache[key] = cached->second;
+                continue;
+            }
+        }
+        cacheOverheadNanos += nanosSince(begin);
+
+        auto parseBegin = chrono::steady_clock::now();
         Function();
+        long long parseNanos = nanosSince(parseBegin);
+        if (end < 0) continue;
+
+        // Only cache when the parser consumed exactly the fingerprinted range
+        cacheMisses++;
+        auto storeBegin = chrono::steady_clock::now();
+        if (current == end) {
+            size_t offset = newParseCacheData.size();
+            serializeTree(parseTreeStack.top()->children.back(), newParseCacheData);
+            usedParseCache[key] = { offset, newParseCacheData.size() - offset, parseNanos, true };
+        }
+        cacheOverheadNanos += nanosSince(storeBegin);
     }
 }
 
@@ -531,8 +716,9 @@ void loadTokensFromFiles() {
     vector<string> kwList = loadFile("keywords.txt");
     vector<string> litList = loadFile("literals.txt");
 
-    for (int i = 0; i < idList.size(); ++i) identifiers[i + 1] = idList[i];
-    for (int i = 0; i < kwList.size(); ++i) keywords[i + 1] = kwList[i];
+    for (size_t i = 0; i < idList.size(); ++i) identifiers[i + 1] = idList[i];
+    for (size_t i = 0; i < kwList.size(); ++i) keywords[i + 1] = kwList[i];
+    for (size_t i = 0; i < litList.size(); ++i) ::literals[i + 1] = litList[i];
 
     ifstream tokenFile("tokens.txt", ios::in);
     if (!tokenFile.is_open()) {
@@ -549,7 +735,8 @@ void loadTokensFromFiles() {
         while (iss >> token) {
             if (token == "<{>" || token == "<}>" || token == "<(>" || token == "<)>" ||
                 token == "<::>" || token == "<+>" || token == "<->" || token == "<*>" ||
-                token == "</>" || token == "<:=>" || token == "<==>" || token == "<!=>" || token == "<<>>") {
+                token == "</>" || token == "<:=>" || token == "<==>" || token == "<!=>" || token == "<<>>" ||
+                token == "<,>") {
                 string symbol = token.substr(1, token.size() - 2);
                 tokens.emplace_back(-1, symbol, symbol);
             }
@@ -571,6 +758,10 @@ void loadTokensFromFiles() {
                     lex = keywords.count(index) ? keywords[index] : "UNKNOWN_KW";
                     tokens.emplace_back(index, "keyword", lex);
                 }
+                else if (cat == "number") {
+                    lex = ::literals.count(index) ? ::literals[index] : "UNKNOWN_LIT";
+                    tokens.emplace_back(index, "number", lex);
+                }
                 else {
                     tokens.emplace_back(index, cat, "UNKNOWN_CAT");
                 }
@@ -611,29 +802,77 @@ void printParseTree(ParseTreeNode* node, const string& prefix = "", bool isLast
     }
 }
 
-int main() {
-    loadTokensFromFiles();
+int main(int argc, char* argv[]) {
+    string perfFile, traceFile;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--no-cache") useParseCache = false;
+        else if (arg == "--perf" && i + 1 < argc) perfFile = argv[++i];
+        else if (arg == "--trace" && i + 1 < argc) traceFile = argv[++i];
+    }
+    if (!perfFile.empty() || !traceFile.empty()) {
+        perfEpoch = chrono::steady_clock::now();
+        perfEnabled = true;
+    }
+
+    {
+        PhaseTimer phase("loadTokensFromFiles");
+        loadTokensFromFiles();
+        phase.setItems(tokens.size(), "tokens");
+    }
 
     ParseTreeNode* root = new ParseTreeNode("Program");
     parseTreeStack.push(root);
 
-    Functions();
+    if (useParseCache) {
+        PhaseTimer phase("loadParseCache");
+        loadParseCache();
+        phase.setItems(parseCache.size(), "functions");
+    }
+
+    {
+        PhaseTimer phase("Functions");
+        Functions();
+        phase.setItems(current, "tokens");
+    }
 
     cout << "Parsing successful!" << endl;
 
+    if (useParseCache) {
+        {
+            PhaseTimer phase("saveParseCache");
+            saveParseCache();
+            phase.setItems(usedParseCache.size(), "functions");
+        }
+        cout << "Function cache: " << cacheHits << " hits, " << cacheMisses << " misses, "
+            << (cacheAvoidedNanos - cacheOverheadNanos) / 1e6 << " ms saved (" << cacheAvoidedNanos / 1e6
+            << " ms of parsing avoided, " << cacheOverheadNanos / 1e6 << " ms of cache overhead)" << endl;
+    }
+
+    long long treeNodes = nodesAllocated;
+
     // Print to console
-    printParseTree(root);
+    {
+        PhaseTimer phase("printParseTree");
+        printParseTree(root);
+        phase.setItems(treeNodes, "nodes");
+    }
 
     // Save to file
     ofstream outFile("tree.txt");
     if (outFile.is_open()) {
+        PhaseTimer phase("printParseTreeToFile");
         printParseTreeToFile(root, outFile);
         outFile.close();
+        phase.setItems(treeNodes, "nodes");
         cout << "Parse tree saved to tree.txt" << endl;
     }
     else {
         cerr << "Unable to open tree.txt for writing" << endl;
     }
 
+    if (!perfFile.empty()) writePerfJson(perfFile, "parser");
+    if (!traceFile.empty()) writeTraceJson(traceFile, "parser");
+
     return 0;
 }
\ No newline at end of file
@@ -4,21 +4,393 @@
 #include <stack>
 #include <sstream>
 #include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <thread>
+#ifdef __unix__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "Perf.h"
 
 using namespace std;
 
+// Operand types; char and bool share the integer representation, float is a double
+enum TACType { TYPE_INT, TYPE_FLOAT, TYPE_CHAR, TYPE_BOOL };
+
+const char* typeName(TACType type) {
+    static const char* names[] = { "int", "float", "char", "bool" };
+    return names[type];
+}
+
+TACType typeFromName(const string& name) {
+    if (name == "float") return TYPE_FLOAT;
+    if (name == "char") return TYPE_CHAR;
+    if (name == "bool") return TYPE_BOOL;
+    return TYPE_INT;
+}
+
+// Math (text) has no TAC operations of its own and is carried as an integer
+TACType typeFromKeyword(const string& keyword) {
+    if (keyword == "Ashriyal") return TYPE_FLOAT;
+    if (keyword == "Harf") return TYPE_CHAR;
+    if (keyword == "Mantiqi") return TYPE_BOOL;
+    return TYPE_INT;
+}
+
+bool isNumberLiteral(const string& s) {
+    size_t i = (s.size() > 1 && s[0] == '-') ? 1 : 0;
+    if (i < s.size() && s[i] == '.') i++;
+    return i < s.size() && isdigit(static_cast<unsigned char>(s[i]));
+}
+
+bool isFloatLiteral(const string& s) {
+    return isNumberLiteral(s) && s.find_first_of(".eE") != string::npos;
+}
+
+// Temps are "%t<N>"; '%' never appears in a source identifier, so they cannot collide
+bool isTemp(const string& name) {
+    return !name.empty() && name[0] == '%';
+}
+
+bool isConversion(const string& op) {
+    return op == "itof" || op == "ftoi";
+}
+
+bool isComparison(const string& op) {
+    return op == "==" || op == "!=" || op == "<>" || op == "<" || op == ">" || op == "<=" || op == ">=";
+}
+
+// Structured form of one TAC line: "dst := lhs op rhs", "dst := lhs", "dst := itof lhs"
+// or a "name(params):" header, with a " ; type" suffix on anything that is not int
+struct TACInstr {
+    bool isLabel = false;
+    string dst;
+    string lhs;
+    string op;
+    string rhs;
+    TACType type = TYPE_INT;    // operand type; the target type for conversions
+    vector<string> params;
+    vector<TACType> paramTypes;
+};
+
+// Type the destination holds after the instruction runs
+TACType resultType(const TACInstr& instr) {
+    if (isComparison(instr.op)) return TYPE_BOOL;
+    if (instr.op.empty() || isConversion(instr.op)) return instr.type;
+    return instr.type == TYPE_FLOAT ? TYPE_FLOAT : TYPE_INT;
+}
+
+// Whether the source operands are doubles
+bool readsFloat(const TACInstr& instr) {
+    if (instr.op == "itof") return false;
+    if (instr.op == "ftoi") return true;
+    return instr.type == TYPE_FLOAT;
+}
+
+TACInstr parseTACLine(const string& line) {
+    TACInstr instr;
+    size_t assign = line.find(" := ");
+    if (assign == string::npos) {
+        instr.isLabel = true;
+        string header = line.substr(0, line.rfind(':'));
+        size_t paren = header.find('(');
+        instr.dst = header.substr(0, paren);
+        if (paren != string::npos) {
+            stringstream params(header.substr(paren + 1, header.rfind(')') - paren - 1));
+            string param;
+            while (getline(params, param, ',')) {
+                istringstream words(param);
+                string first, second;
+                words >> first >> second;
+                if (first.empty()) continue;
+                instr.params.push_back(second.empty() ? first : second);
+                instr.paramTypes.push_back(second.empty() ? TYPE_INT : typeFromName(first));
+            }
+        }
+        return instr;
+    }
+
+    string code = line;
+    size_t suffix = code.find(" ; ");
+    if (suffix != string::npos) {
+        instr.type = typeFromName(code.substr(suffix + 3));
+        code.erase(suffix);
+    }
+
+    instr.dst = code.substr(0, assign);
+    istringstream rhs(code.substr(assign + 4));
+    string first, second, third;
+    rhs >> first >> second >> third;
+    if (isConversion(first)) {
+        instr.op = first;
+        instr.lhs = second;
+    }
+    else {
+        instr.lhs = first;
+        instr.op = second;
+        instr.rhs = third;
+    }
+    return instr;
+}
+
+struct Symbol {
+    TACType type;
+    string tacName;     // differs from the source name when the name was already used in the function
+};
+
+// A flat open-addressed table with linear probing, keyed by name
+template <typename Value>
+class FlatTable {
+private:
+    struct Entry {
+        string name;
+        Value value;
+        bool used = false;
+    };
+
+    vector<Entry> entries = vector<Entry>(8);
+    size_t count = 0;
+
+    static uint64_t hashName(const string& name) {
+        uint64_t hash = fnvOffset;
+        fnvMix(hash, name);
+        return hash;
+    }
+
+    void grow() {
+        vector<Entry> old(entries.size() * 2);
+        old.swap(entries);
+        count = 0;
+        for (const auto& entry : old) {
+            if (entry.used) insert(entry.name, entry.value);
+        }
+    }
+
+public:
+    void insert(const string& name, const Value& value) {
+        if ((count + 1) * 4 > entries.size() * 3) grow();
+        size_t mask = entries.size() - 1;
+        for (size_t i = hashName(name) & mask;; i = (i + 1) & mask) {
+            if (!entries[i].used) {
+                entries[i] = { name, value, true };
+                count++;
+                return;
+            }
+            if (entries[i].name == name) {
+                entries[i].value = value;
+                return;
+            }
+        }
+    }
+
+    const Value* find(const string& name) const {
+        size_t mask = entries.size() - 1;
+        for (size_t i = hashName(name) & mask; entries[i].used; i = (i + 1) & mask) {
+            if (entries[i].name == name) return &entries[i].value;
+        }
+        return nullptr;
+    }
+
+    void clear() {
+        entries.assign(8, Entry());
+        count = 0;
+    }
+};
+
+// One CompStmt scope
+typedef FlatTable<Symbol> ScopeTable;
+
+// Every binding of a source name in a function gets its own TAC name, so a TAC name has one
+// type for the whole function and a slot is never shared by two bindings. The first binding
+// of a name keeps it; later ones are renamed name.N. Undeclared uses share one implicit int
+// binding per name.
+class SymbolTable {
+private:
+    struct NameState {
+        string implicitName;    // TAC name of undeclared uses; empty until the first one
+    };
+
+    vector<ScopeTable> scopes;
+    FlatTable<NameState> names;     // source names bound so far in the function
+    FlatTable<TACType> types;       // by TAC name: declarations, implicit names and temps
+    int renamed = 0;
+
+    // The bare name for the first binding of 'name', a fresh name.N for every later one
+    string bind(const string& name, TACType type) {
+        string tacName = name;
+        if (names.find(name)) tacName = name + "." + to_string(++renamed);
+        else names.insert(name, NameState());
+        types.insert(tacName, type);
+        return tacName;
+    }
+
+public:
+    void pushScope() {
+        scopes.emplace_back();
+    }
+
+    void popScope() {
+        scopes.pop_back();
+    }
+
+    // Starts a function: names and types do not carry over
+    void reset() {
+        scopes.clear();
+        names.clear();
+        types.clear();
+        renamed = 0;
+    }
+
+    // Returns the TAC name. A redeclaration in the same scope with the same type keeps its
+    // name; with another type it is a new binding, and the one it replaces goes to 'replaced'.
+    string declare(const string& name, TACType type, Symbol* replaced = nullptr) {
+        if (scopes.empty()) pushScope();
+        const Symbol* local = scopes.back().find(name);
+        if (local && local->type == type) return local->tacName;
+        if (local && replaced) *replaced = *local;
+
+        string tacName = bind(name, type);
+        scopes.back().insert(name, { type, tacName });
+        return tacName;
+    }
+
+    // The TAC name an identifier refers to; undeclared names get an implicit int binding
+    string resolve(const string& name) {
+        if (const Symbol* symbol = lookup(name)) return symbol->tacName;
+
+        const NameState* state = names.find(name);
+        if (state && !state->implicitName.empty()) return state->implicitName;
+        string tacName = bind(name, TYPE_INT);
+        names.insert(name, { tacName });
+        return tacName;
+    }
+
+    const Symbol* lookup(const string& name) const {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            if (const Symbol* symbol = it->find(name)) return symbol;
+        }
+        return nullptr;
+    }
+
+    void setType(const string& tacName, TACType type) {
+        types.insert(tacName, type);
+    }
+
+    // Names never bound in this function default to int
+    TACType typeOf(const string& tacName) const {
+        const TACType* type = types.find(tacName);
+        return type ? *type : TYPE_INT;
+    }
+};
+
 class TACGenerator {
 private:
     vector<string> tacCode;
+    vector<TACInstr> instrs;
     int tempCounter = 0;
+    SymbolTable symbolTable;
 
 public:
-    string newTemp() {
-        return "t" + to_string(tempCounter++);
+    string newTemp(TACType type = TYPE_INT) {
+        string temp = "%t" + to_string(tempCounter++);
+        symbolTable.setType(temp, type);
+        return temp;
     }
 
     void emit(const string& code) {
         tacCode.push_back(code);
+        instrs.push_back(parseTACLine(code));
+    }
+
+    void emit(string&& code) {
+        instrs.push_back(parseTACLine(code));
+        tacCode.push_back(move(code));
+    }
+
+    void emit(const string& code, TACType type) {
+        emit(type == TYPE_INT ? code : code + " ; " + typeName(type));
+    }
+
+    SymbolTable& symbols() {
+        return symbolTable;
+    }
+
+    // A same-scope redeclaration with a new type starts from the old value, converted
+    string declare(const string& name, TACType type) {
+        Symbol replaced = { TYPE_INT, "" };
+        string tacName = symbolTable.declare(name, type, &replaced);
+        if (!replaced.tacName.empty()) emit(tacName + " := " + convert(replaced.tacName, type), type);
+        return tacName;
+    }
+
+    string resolve(const string& name) {
+        return symbolTable.resolve(name);
+    }
+
+    TACType typeOf(const string& operand) const {
+        if (isNumberLiteral(operand)) return isFloatLiteral(operand) ? TYPE_FLOAT : TYPE_INT;
+        return symbolTable.typeOf(operand);
+    }
+
+    // Emits an itof/ftoi when the operand is on the other side of the int/float split
+    string convert(const string& operand, TACType to) {
+        bool fromFloat = typeOf(operand) == TYPE_FLOAT;
+        if (fromFloat == (to == TYPE_FLOAT)) return operand;
+        string temp = newTemp(to);
+        emit(temp + " := " + (fromFloat ? "ftoi " : "itof ") + operand, to);
+        return temp;
+    }
+
+    // Float if either side is float, otherwise the shared type (int when they differ)
+    string emitBinary(string left, const string& op, string right) {
+        TACType leftType = typeOf(left);
+        TACType rightType = typeOf(right);
+        TACType type = (leftType == TYPE_FLOAT || rightType == TYPE_FLOAT) ? TYPE_FLOAT
+            : (leftType == rightType ? leftType : TYPE_INT);
+        left = convert(left, type);
+        right = convert(right, type);
+
+        TACInstr probe;
+        probe.op = op;
+        probe.type = type;
+        string temp = newTemp(resultType(probe));
+        emit(temp + " := " + left + " " + op + " " + right, type);
+        return temp;
+    }
+
+    // Temps are function-local so cached functions can be spliced anywhere
+    void beginFunction(const string& name, const vector<string>& params, const vector<TACType>& types) {
+        tempCounter = 0;
+        symbolTable.reset();
+        string header = name + "(";
+        for (size_t i = 0; i < params.size(); ++i) {
+            header += (i ? ", " : "") + (types[i] == TYPE_INT ? "" : string(typeName(types[i])) + " ") + params[i];
+        }
+        emit(header + "):");
+    }
+
+    const vector<TACInstr>& instructions() const {
+        return instrs;
+    }
+
+    size_t size() const {
+        return tacCode.size();
+    }
+
+    // Appends every line from 'start' on, newline-terminated
+    void appendLinesFrom(size_t start, string& out) const {
+        for (size_t i = start; i < tacCode.size(); ++i) {
+            out += tacCode[i];
+            out += '\n';
+        }
     }
 
     void saveToFile(const string& filename) {
@@ -46,9 +418,40 @@ struct TreeNode {
     string value;
     vector<TreeNode*> children;
 
-    TreeNode(const string& t, const string& v = "") : type(t), value(v) {}
+    TreeNode(const string& t, const string& v = "") : type(t), value(v) {
+        countNode();
+    }
 };
 
+// Parses one tree.txt line into a node and reports its indentation level
+TreeNode* parseTreeLine(const string& line, size_t& indent) {
+    // Count indentation level
+    indent = 0;
+    while (indent < line.size() && (line[indent] == ' ' || line[indent] == '|' || line[indent] == '+')) {
+        indent++;
+    }
+
+    // Clean the line
+    string nodeStr = line.substr(indent);
+    size_t prefix = nodeStr.find("-- ");
+    if (prefix != string::npos) {
+        nodeStr = nodeStr.substr(prefix + 3);
+    }
+
+    // Extract type and value
+    string nodeType, nodeValue;
+    size_t paren = nodeStr.find("(");
+    if (paren != string::npos) {
+        nodeType = nodeStr.substr(0, paren - 1);
+        nodeValue = nodeStr.substr(paren + 1, nodeStr.find(")") - paren - 1);
+    }
+    else {
+        nodeType = nodeStr;
+    }
+
+    return new TreeNode(nodeType, nodeValue);
+}
+
 TreeNode* buildTreeFromFile(const string& filename) {
     ifstream file(filename);
     if (!file.is_open()) {
@@ -61,32 +464,9 @@ TreeNode* buildTreeFromFile(const string& filename) {
     string line;
 
     while (getline(file, line)) {
-        // Count indentation level
-        size_t indent = 0;
-        while (indent < line.size() && (line[indent] == ' ' || line[indent] == '|' || line[indent] == '+')) {
-            indent++;
-        }
-
-        // Clean the line
-        string nodeStr = line.substr(indent);
-        size_t prefix = nodeStr.find("-- ");
-        if (prefix != string::npos) {
-            nodeStr = nodeStr.substr(prefix + 3);
-        }
-
-        // Extract type and value
-        string nodeType, nodeValue;
-        size_t paren = nodeStr.find("(");
-        if (paren != string::npos) {
-            nodeType = nodeStr.substr(0, paren - 1);
-            nodeValue = nodeStr.substr(paren + 1, nodeStr.find(")") - paren - 1);
-        }
-        else {
-            nodeType = nodeStr;
-        }
-
         // Create node
-        TreeNode* newNode = new TreeNode(nodeType, nodeValue);
+        size_t indent;
+        TreeNode* newNode = parseTreeLine(line, indent);
 
         // Set root if first node
         if (nodeStack.empty()) {
@@ -110,11 +490,141 @@ TreeNode* buildTreeFromFile(const string& filename) {
     return root;
 }
 
+// Builds the same tree as buildTreeFromFile, with each top-level subtree (the lines from one
+// first-child-indent line to the next) built on its own thread. Falls back to the serial
+// loader when only one thread would run, since mapping the file and indexing every line costs
+// time and memory that only pays off across threads, and when the file cannot be mapped or
+// does not have that shape.
+TreeNode* buildTreeFromFileParallel(const string& filename, unsigned jobs) {
+#ifdef __unix__
+    // Threads below this much input cost more to start than they save
+    const size_t minBytesPerThread = 256 * 1024;
+
+    if (jobs < 2) return buildTreeFromFile(filename);
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return buildTreeFromFile(filename);
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < 2 * minBytesPerThread) {
+        close(fd);
+        return buildTreeFromFile(filename);
+    }
+    size_t size = info.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return buildTreeFromFile(filename);
+    const char* data = static_cast<const char*>(mapped);
+
+    // Line starts as getline sees them; a trailing newline does not open another line
+    vector<size_t> starts;
+    vector<size_t> heads;
+    size_t rootIndent = 0, childIndent = 0;
+    bool wellFormed = true;
+    size_t pos = 0;
+    while (pos < size && wellFormed) {
+        const char* newline = static_cast<const char*>(memchr(data + pos, '\n', size - pos));
+        size_t end = newline ? newline - data : size;
+
+        size_t indent = 0;
+        while (pos + indent < end && (data[pos + indent] == ' ' || data[pos + indent] == '|' || data[pos + indent] == '+')) {
+            indent++;
+        }
+
+        if (starts.empty()) rootIndent = indent;
+        else if (starts.size() == 1) childIndent = indent;
+        if (starts.size() == 1 || (starts.size() > 1 && indent == childIndent)) heads.push_back(starts.size());
+        else if (starts.size() > 1 && indent < childIndent) wellFormed = false;
+
+        starts.push_back(pos);
+        pos = end + 1;
+    }
+    starts.push_back(pos);
+
+    if (!wellFormed || heads.empty() || rootIndent >= childIndent) {
+        munmap(mapped, size);
+        return buildTreeFromFile(filename);
+    }
+
+    // Reuses the caller's buffer, as getline does in the serial loader
+    auto lineAt = [&](size_t i, string& line) -> const string& {
+        line.assign(data + starts[i], starts[i + 1] - 1 - starts[i]);
+        return line;
+    };
+
+    // Every line in a chunk is indented past its head, so the head is never popped
+    auto buildChunk = [&](size_t first, size_t last) {
+        string line;
+        size_t indent;
+        TreeNode* head = parseTreeLine(lineAt(first, line), indent);
+        stack<pair<TreeNode*, size_t>> nodeStack;
+        nodeStack.push({ head, indent });
+        for (size_t i = first + 1; i < last; ++i) {
+            TreeNode* node = parseTreeLine(lineAt(i, line), indent);
+            while (nodeStack.top().second >= indent) {
+                nodeStack.pop();
+            }
+            nodeStack.top().first->children.push_back(node);
+            nodeStack.push({ node, indent });
+        }
+        return head;
+    };
+
+    size_t lineCount = starts.size() - 1;
+    size_t chunkCount = heads.size();
+    heads.push_back(lineCount);
+
+    // Contiguous runs of chunks with roughly equal bytes
+    size_t threadCount = min<size_t>({ jobs, chunkCount, size / minBytesPerThread });
+    if (threadCount < 2) {
+        munmap(mapped, size);
+        return buildTreeFromFile(filename);
+    }
+    vector<size_t> firstChunk = { 0 };
+    for (size_t c = 0; c < chunkCount && firstChunk.size() < threadCount; ++c) {
+        if (starts[heads[c + 1]] >= size * firstChunk.size() / threadCount) firstChunk.push_back(c + 1);
+    }
+    firstChunk.push_back(chunkCount);
+
+    vector<TreeNode*> subtrees(chunkCount);
+    vector<AllocationCounts> allocations(firstChunk.size());
+    auto buildRange = [&](size_t t) {
+        for (size_t c = firstChunk[t]; c < firstChunk[t + 1]; ++c) {
+            subtrees[c] = buildChunk(heads[c], heads[c + 1]);
+        }
+        allocations[t] = threadAllocations();
+    };
+
+    vector<thread> workers;
+    for (size_t t = 1; t + 1 < firstChunk.size(); ++t) {
+        workers.emplace_back(buildRange, t);
+    }
+    buildRange(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    // Range 0 ran here and is already in this thread's counters
+    for (size_t t = 1; t + 1 < firstChunk.size(); ++t) {
+        addAllocations(allocations[t]);
+    }
+
+    string line;
+    size_t indent;
+    TreeNode* root = parseTreeLine(lineAt(0, line), indent);
+    root->children = move(subtrees);
+    munmap(mapped, size);
+    return root;
+#else
+    return buildTreeFromFile(filename);
+#endif
+}
+
 string processNode(TreeNode* node, TACGenerator& tacGen) {
     if (!node) return "";
 
     // Handle leaf nodes
     if (node->type == "Identifier") {
+        return tacGen.resolve(node->value);
+    }
+    else if (node->type == "Number") {
         return node->value;
     }
     else if (node->type == "Operator") {
@@ -128,7 +638,8 @@ string processNode(TreeNode* node, TACGenerator& tacGen) {
             if (node->children[1]->type == "Operator" && node->children[1]->value == ":=") {
                 string left = processNode(node->children[0], tacGen);
                 string right = processNode(node->children[2], tacGen);
-                tacGen.emit(left + " := " + right);
+                TACType type = tacGen.typeOf(left);
+                tacGen.emit(left + " := " + tacGen.convert(right, type), type);
                 return left;
             }
             // Binary operation case
@@ -136,15 +647,30 @@ string processNode(TreeNode* node, TACGenerator& tacGen) {
                 string left = processNode(node->children[0], tacGen);
                 string op = node->children[1]->value;
                 string right = processNode(node->children[2], tacGen);
-                string temp = tacGen.newTemp();
-                tacGen.emit(temp + " := " + left + " " + op + " " + right);
-                return temp;
+                return tacGen.emitBinary(left, op, right);
             }
         }
         return processNode(node->children[0], tacGen);
     }
-    // Handle Rvalue, Mag, Term, Factor nodes by processing their first child
-    else if (node->type == "Rvalue" || node->type == "Mag" || node->type == "Term" || node->type == "Factor") {
+    // Handle Rvalue, Mag, Term nodes as left-associative operator chains
+    else if (node->type == "Rvalue" || node->type == "Mag" || node->type == "Term") {
+        if (!node->children.empty()) {
+            string result = processNode(node->children[0], tacGen);
+            for (size_t i = 1; i + 1 < node->children.size(); i += 2) {
+                string op = node->children[i]->value;
+                string right = processNode(node->children[i + 1], tacGen);
+                result = tacGen.emitBinary(result, op, right);
+            }
+            return result;
+        }
+    }
+    // Handle Factor nodes, skipping the parentheses around a nested Expr
+    else if (node->type == "Factor") {
+        for (auto child : node->children) {
+            if (child->type == "Expr") {
+                return processNode(child, tacGen);
+            }
+        }
         if (!node->children.empty()) {
             return processNode(node->children[0], tacGen);
         }
@@ -162,17 +688,1242 @@ string processNode(TreeNode* node, TACGenerator& tacGen) {
         }
     }
     else if (node->type == "CompStmt") {
+        tacGen.symbols().pushScope();
         for (auto child : node->children) {
             processNode(child, tacGen);
         }
+        tacGen.symbols().popScope();
+    }
+    // Record declared types in the innermost scope
+    else if (node->type == "Declaration") {
+        TACType type = TYPE_INT;
+        for (auto child : node->children) {
+            if (child->type == "Type") {
+                type = typeFromKeyword(child->value);
+            }
+            else if (child->type == "IdentList") {
+                for (auto ident : child->children) {
+                    if (ident->type == "Identifier") tacGen.declare(ident->value, type);
+                }
+            }
+        }
     }
 
     return "";
 }
 
-int main() {
+// Per-function TAC cache, keyed by a hash of the function's subtree
+// Loaded entries point into the file as read; functions lowered this run go to a second buffer
+class TACCache {
+private:
+    struct Entry {
+        size_t offset;          // of the newline-terminated TAC lines within their buffer
+        size_t length;
+        long long lowerNanos;   // cost of lowering the function when it was cached
+        bool fresh;             // in freshData rather than data
+    };
+
+    const string version = "tac-cache 7";
+    string filename;
+    string data;
+    string freshData;
+    unordered_map<uint64_t, Entry> stored;
+    unordered_map<uint64_t, Entry> used;
+
+public:
+    int hits = 0;
+    int misses = 0;
+    long long avoidedNanos = 0;     // lowering time of the functions that were hits
+    long long overheadNanos = 0;    // everything the cache itself costs, including file I/O
+
+    TACCache(const string& file) : filename(file) {}
+
+    size_t size() const {
+        return stored.size();
+    }
+
+    size_t usedSize() const {
+        return used.size();
+    }
+
+    // Reads the whole file once and indexes it; entries are "<key> <lower ns> <bytes>\n<lines>"
+    void load() {
+        auto begin = chrono::steady_clock::now();
+        ifstream file(filename, ios::binary | ios::ate);
+        if (file.is_open()) {
+            data.resize(file.tellg());
+            file.seekg(0);
+            file.read(&data[0], data.size());
+        }
+
+        const char* start = data.data();
+        const char* end = start + data.size();
+        if (data.compare(0, version.size(), version) != 0 || data[version.size()] != '\n') end = start;
+
+        const char* pos = start + version.size() + 1;
+        while (pos < end) {
+            char* next;
+            uint64_t key = strtoull(pos, &next, 16);
+            long long nanos = strtoll(next, &next, 10);
+            size_t length = strtoull(next, &next, 10);
+            if (next >= end || *next != '\n' || length > static_cast<size_t>(end - next - 1)) break;
+            if (length && next[length] != '\n') break;
+
+            size_t offset = next + 1 - start;
+            stored[key] = { offset, length, nanos, false };
+            pos = start + offset + length;
+        }
+        overheadNanos += nanosSince(begin);
+    }
+
+    // Rewrites the file only when this run lowered something new or stopped using an entry
+    void save() {
+        if (misses == 0 && used.size() == stored.size()) return;
+
+        auto begin = chrono::steady_clock::now();
+        ofstream file(filename, ios::binary);
+        if (!file.is_open()) {
+            cerr << "Unable to open " << filename << " for writing" << endl;
+            return;
+        }
+
+        file << version << '\n';
+        for (const auto& entry : used) {
+            const Entry& cached = entry.second;
+            const string& buffer = cached.fresh ? freshData : data;
+            file << hex << entry.first << dec << ' ' << cached.lowerNanos << ' ' << cached.length << '\n';
+            file.write(buffer.data() + cached.offset, cached.length);
+        }
+        file.close();
+        overheadNanos += nanosSince(begin);
+    }
+
+    // Emits the cached lines for 'key'; false on a miss
+    bool emit(uint64_t key, TACGenerator& tacGen) {
+        auto it = stored.find(key);
+        if (it == stored.end()) return false;
+
+        const char* pos = data.data() + it->second.offset;
+        const char* end = pos + it->second.length;
+        while (pos < end) {
+            const char* newline = static_cast<const char*>(memchr(pos, '\n', end - pos));
+            tacGen.emit(string(pos, newline));
+            pos = newline + 1;
+        }
+        used[key] = it->second;
+        avoidedNanos += it->second.lowerNanos;
+        hits++;
+        return true;
+    }
+
+    void store(uint64_t key, const TACGenerator& tacGen, size_t start, long long lowerNanos) {
+        size_t offset = freshData.size();
+        tacGen.appendLinesFrom(start, freshData);
+        used[key] = { offset, freshData.size() - offset, lowerNanos, true };
+        misses++;
+    }
+};
+
+// Hash of the types, values and shape of a subtree; it runs on every function, hit or miss
+void fingerprintTree(TreeNode* node, uint64_t& hash) {
+    fnvMixFieldWords(hash, node->type);
+    fnvMixFieldWords(hash, node->value);
+    fnvMixWord(hash, node->children.size());
+    for (auto child : node->children) {
+        fingerprintTree(child, hash);
+    }
+}
+
+// Collects the identifier and type of every Arg under an ArgList, in order
+void collectParams(TreeNode* node, vector<string>& params, vector<TACType>& types) {
+    if (node->type == "Arg") {
+        TACType type = TYPE_INT;
+        for (auto child : node->children) {
+            if (child->type == "Type") type = typeFromKeyword(child->value);
+            else if (child->type == "Identifier") {
+                params.push_back(child->value);
+                types.push_back(type);
+            }
+        }
+        return;
+    }
+    for (auto child : node->children) {
+        collectParams(child, params, types);
+    }
+}
+
+void lowerFunction(TreeNode* function, TACGenerator& tacGen) {
+    string name;
+    vector<string> params;
+    vector<TACType> types;
+    for (auto child : function->children) {
+        if (child->type == "Function Name") {
+            name = child->value;
+        }
+        else if (child->type == "ArgList") {
+            collectParams(child, params, types);
+        }
+    }
+
+    // Arguments live in a scope of their own around the body
+    tacGen.beginFunction(name, params, types);
+    tacGen.symbols().pushScope();
+    for (size_t i = 0; i < params.size(); ++i) {
+        tacGen.declare(params[i], types[i]);
+    }
+    for (auto child : function->children) {
+        if (child->type == "CompStmt") {
+            processNode(child, tacGen);
+            break;
+        }
+    }
+    tacGen.symbols().popScope();
+}
+
+// TAC split at its "name(params):" headers; code before the first header forms an unnamed function
+struct TACFunction {
+    string name;
+    vector<string> params;
+    vector<TACType> paramTypes;
+    vector<TACInstr> body;
+};
+
+vector<TACFunction> splitFunctions(const vector<TACInstr>& instrs) {
+    vector<TACFunction> functions;
+    for (const auto& instr : instrs) {
+        if (instr.isLabel) {
+            functions.push_back({ instr.dst, instr.params, instr.paramTypes, {} });
+            continue;
+        }
+        if (functions.empty()) functions.push_back({});
+        functions.back().body.push_back(instr);
+    }
+    return functions;
+}
+
+// The 64-bit pattern of a literal read as an integer or as a double
+long long literalBits(const string& literal, bool asFloat) {
+    if (!asFloat) return isFloatLiteral(literal) ? (long long)stod(literal) : stoll(literal);
+    double value = stod(literal);
+    long long bits;
+    memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+// Dense frame slots for a function's variables, temps and constants; doubles are kept as
+// their bit pattern. Shared by the interpreter and the JIT so both see the same frame.
+struct FrameLayout {
+    vector<long long> initial;      // constants are preloaded, everything else is zero
+    vector<string> names;           // empty for constants
+    vector<TACType> types;
+    vector<int> paramSlots;
+    unordered_map<string, int> slots;
+
+    // Literals get one slot per representation they are read as
+    int slotOf(const string& operand, bool asFloat) {
+        bool constant = isNumberLiteral(operand);
+        string key = constant ? operand + (asFloat ? "#f" : "#i") : operand;
+        auto it = slots.find(key);
+        if (it != slots.end()) return it->second;
+
+        int slot = initial.size();
+        initial.push_back(constant ? literalBits(operand, asFloat) : 0);
+        names.push_back(constant ? "" : operand);
+        types.push_back(asFloat ? TYPE_FLOAT : TYPE_INT);
+        slots[key] = slot;
+        return slot;
+    }
+
+    void addParams(const TACFunction& fn) {
+        for (size_t p = 0; p < fn.params.size(); ++p) {
+            int slot = slotOf(fn.params[p], fn.paramTypes[p] == TYPE_FLOAT);
+            types[slot] = fn.paramTypes[p];
+            paramSlots.push_back(slot);
+        }
+    }
+
+    // Records the destination's type; returns its slot
+    int define(const TACInstr& instr) {
+        int slot = slotOf(instr.dst, false);
+        types[slot] = resultType(instr);
+        return slot;
+    }
+
+    vector<long long> frameFor(const vector<string>& args) const {
+        vector<long long> frame = initial;
+        for (size_t p = 0; p < paramSlots.size() && p < args.size(); ++p) {
+            int slot = paramSlots[p];
+            if (types[slot] == TYPE_FLOAT) {
+                double value = atof(args[p].c_str());
+                memcpy(&frame[slot], &value, sizeof value);
+            }
+            else {
+                frame[slot] = atoll(args[p].c_str());
+            }
+        }
+        return frame;
+    }
+
+    // Prints every source variable; temps and constants are skipped
+    void print(const vector<long long>& frame) const {
+        for (size_t slot = 0; slot < names.size(); ++slot) {
+            const string& name = names[slot];
+            if (name.empty() || isTemp(name)) continue;
+
+            cout << "  " << name << " = ";
+            if (types[slot] == TYPE_FLOAT) {
+                double value;
+                memcpy(&value, &frame[slot], sizeof value);
+                cout << value;
+            }
+            else {
+                cout << frame[slot];
+            }
+            cout << " (" << typeName(types[slot]) << ")" << endl;
+        }
+    }
+};
+
+// Runs 'call' on 'iterations' fresh copies of 'initial' and returns the nanoseconds spent in
+// 'call' alone, or -1 as soon as it fails. Frames are reset in batches outside the timed
+// region so short functions do not measure the copy. 'frame' is left holding the last run.
+template <typename Slot, typename Call>
+long long timeRuns(const vector<Slot>& initial, long long iterations, Call call, vector<Slot>& frame) {
+    const long long batch = 256;
+    size_t slots = initial.size();
+    vector<Slot> frames;
+    long long nanos = 0, count = 0;
+    for (long long done = 0; done < iterations; done += count) {
+        count = min(batch, iterations - done);
+        frames.clear();
+        for (long long i = 0; i < count; ++i) {
+            frames.insert(frames.end(), initial.begin(), initial.end());
+        }
+
+        auto begin = chrono::steady_clock::now();
+        for (long long i = 0; i < count; ++i) {
+            if (!call(frames.data() + i * slots)) return -1;
+        }
+        nanos += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count();
+    }
+    frame.assign(frames.end() - slots, frames.end());
+    return nanos;
+}
+
+bool isMalformed(const TACInstr& instr) {
+    bool unary = instr.op.empty() || isConversion(instr.op);
+    return instr.dst.empty() || instr.lhs.empty() || (!unary && instr.rhs.empty());
+}
+
+// Executes TAC with every variable, temp and constant resolved to a frame slot
+class TACInterpreter {
+private:
+    enum OpCode {
+        OP_MOV,
+        OP_ADD_I, OP_SUB_I, OP_MUL_I, OP_DIV_I, OP_EQ_I, OP_NE_I, OP_LT_I, OP_GT_I, OP_LE_I, OP_GE_I,
+        OP_ADD_F, OP_SUB_F, OP_MUL_F, OP_DIV_F, OP_EQ_F, OP_NE_F, OP_LT_F, OP_GT_F, OP_LE_F, OP_GE_F,
+        OP_ITOF, OP_FTOI, OP_HALT
+    };
+    static const int floatOffset = OP_ADD_F - OP_ADD_I;
+
+    union Value {
+        long long i;
+        double f;
+    };
+
+    struct Op {
+        int code;
+        int dst;
+        int a;
+        int b;
+    };
+
+    struct CompiledFunction {
+        string name;
+        vector<Op> code;
+        FrameLayout layout;
+    };
+
+    vector<CompiledFunction> functions;
+
+    static int opCode(const string& op) {
+        static const unordered_map<string, int> codes = {
+            { "+", OP_ADD_I }, { "-", OP_SUB_I }, { "*", OP_MUL_I }, { "/", OP_DIV_I },
+            { "==", OP_EQ_I }, { "!=", OP_NE_I }, { "<>", OP_NE_I },
+            { "<", OP_LT_I }, { ">", OP_GT_I }, { "<=", OP_LE_I }, { ">=", OP_GE_I },
+            { "itof", OP_ITOF }, { "ftoi", OP_FTOI },
+        };
+        auto it = codes.find(op);
+        return it == codes.end() ? -1 : it->second;
+    }
+
+    // Returns false on integer division by zero or LLONG_MIN / -1, which has no int64 result.
+    // Integer +, - and * wrap like the native backend.
+    static bool execute(const Op* ip, Value* frame) {
+        typedef unsigned long long u64;
+#ifdef __GNUC__
+        static const void* labels[] = {
+            &&handle_OP_MOV,
+            &&handle_OP_ADD_I, &&handle_OP_SUB_I, &&handle_OP_MUL_I, &&handle_OP_DIV_I, &&handle_OP_EQ_I,
+            &&handle_OP_NE_I, &&handle_OP_LT_I, &&handle_OP_GT_I, &&handle_OP_LE_I, &&handle_OP_GE_I,
+            &&handle_OP_ADD_F, &&handle_OP_SUB_F, &&handle_OP_MUL_F, &&handle_OP_DIV_F, &&handle_OP_EQ_F,
+            &&handle_OP_NE_F, &&handle_OP_LT_F, &&handle_OP_GT_F, &&handle_OP_LE_F, &&handle_OP_GE_F,
+            &&handle_OP_ITOF, &&handle_OP_FTOI, &&handle_OP_HALT };
+#define HANDLER(code) handle_##code
+#define NEXT() ++ip; goto *labels[ip->code]
+        goto *labels[ip->code];
+#else
+#define HANDLER(code) case code
+#define NEXT() ++ip; continue
+        for (;;) switch (ip->code) {
+#endif
+        HANDLER(OP_MOV): frame[ip->dst] = frame[ip->a]; NEXT();
+        HANDLER(OP_ADD_I): frame[ip->dst].i = (long long)((u64)frame[ip->a].i + (u64)frame[ip->b].i); NEXT();
+        HANDLER(OP_SUB_I): frame[ip->dst].i = (long long)((u64)frame[ip->a].i - (u64)frame[ip->b].i); NEXT();
+        HANDLER(OP_MUL_I): frame[ip->dst].i = (long long)((u64)frame[ip->a].i * (u64)frame[ip->b].i); NEXT();
+        HANDLER(OP_DIV_I):
+            if (frame[ip->b].i == 0 || (frame[ip->b].i == -1 && frame[ip->a].i == LLONG_MIN)) return false;
+            frame[ip->dst].i = frame[ip->a].i / frame[ip->b].i; NEXT();
+        HANDLER(OP_EQ_I): frame[ip->dst].i = frame[ip->a].i == frame[ip->b].i; NEXT();
+        HANDLER(OP_NE_I): frame[ip->dst].i = frame[ip->a].i != frame[ip->b].i; NEXT();
+        HANDLER(OP_LT_I): frame[ip->dst].i = frame[ip->a].i < frame[ip->b].i; NEXT();
+        HANDLER(OP_GT_I): frame[ip->dst].i = frame[ip->a].i > frame[ip->b].i; NEXT();
+        HANDLER(OP_LE_I): frame[ip->dst].i = frame[ip->a].i <= frame[ip->b].i; NEXT();
+        HANDLER(OP_GE_I): frame[ip->dst].i = frame[ip->a].i >= frame[ip->b].i; NEXT();
+        HANDLER(OP_ADD_F): frame[ip->dst].f = frame[ip->a].f + frame[ip->b].f; NEXT();
+        HANDLER(OP_SUB_F): frame[ip->dst].f = frame[ip->a].f - frame[ip->b].f; NEXT();
+        HANDLER(OP_MUL_F): frame[ip->dst].f = frame[ip->a].f * frame[ip->b].f; NEXT();
+        HANDLER(OP_DIV_F): frame[ip->dst].f = frame[ip->a].f / frame[ip->b].f; NEXT();
+        HANDLER(OP_EQ_F): frame[ip->dst].i = frame[ip->a].f == frame[ip->b].f; NEXT();
+        HANDLER(OP_NE_F): frame[ip->dst].i = frame[ip->a].f != frame[ip->b].f; NEXT();
+        HANDLER(OP_LT_F): frame[ip->dst].i = frame[ip->a].f < frame[ip->b].f; NEXT();
+        HANDLER(OP_GT_F): frame[ip->dst].i = frame[ip->a].f > frame[ip->b].f; NEXT();
+        HANDLER(OP_LE_F): frame[ip->dst].i = frame[ip->a].f <= frame[ip->b].f; NEXT();
+        HANDLER(OP_GE_F): frame[ip->dst].i = frame[ip->a].f >= frame[ip->b].f; NEXT();
+        HANDLER(OP_ITOF): frame[ip->dst].f = (double)frame[ip->a].i; NEXT();
+        HANDLER(OP_FTOI): frame[ip->dst].i = (long long)frame[ip->a].f; NEXT();
+        HANDLER(OP_HALT): return true;
+#ifndef __GNUC__
+        }
+#endif
+#undef NEXT
+#undef HANDLER
+    }
+
+public:
+    bool load(const vector<TACInstr>& instrs) {
+        functions.clear();
+        for (const auto& source : splitFunctions(instrs)) {
+            functions.push_back({});
+            CompiledFunction& fn = functions.back();
+            fn.name = source.name;
+            fn.layout.addParams(source);
+
+            for (const auto& instr : source.body) {
+                if (isMalformed(instr)) {
+                    cerr << "Malformed TAC in " << fn.name << ": " << instr.dst << " := " << instr.lhs << endl;
+                    return false;
+                }
+
+                int code = instr.op.empty() ? OP_MOV : opCode(instr.op);
+                if (code < 0) {
+                    cerr << "Unknown TAC operator '" << instr.op << "'" << endl;
+                    return false;
+                }
+                if (code >= OP_ADD_I && code <= OP_GE_I && instr.type == TYPE_FLOAT) code += floatOffset;
+
+                bool asFloat = readsFloat(instr);
+                int a = fn.layout.slotOf(instr.lhs, asFloat);
+                int b = instr.rhs.empty() ? 0 : fn.layout.slotOf(instr.rhs, asFloat);
+                fn.code.push_back({ code, fn.layout.define(instr), a, b });
+            }
+            fn.code.push_back({ OP_HALT, 0, 0, 0 });
+        }
+        return true;
+    }
+
+    // Runs 'entry' (the first function when empty) and prints its variables
+    bool run(const string& entry, const vector<string>& args, long long iterations) {
+        const CompiledFunction* fn = nullptr;
+        for (const auto& f : functions) {
+            if (entry.empty() || f.name == entry) {
+                fn = &f;
+                break;
+            }
+        }
+        if (!fn) {
+            cerr << "No TAC function named '" << entry << "'" << endl;
+            return false;
+        }
+
+        vector<long long> bits = fn->layout.frameFor(args);
+        vector<Value> initial(bits.size());
+        memcpy(initial.data(), bits.data(), bits.size() * sizeof(long long));
+
+        vector<Value> frame;
+        const Op* code = fn->code.data();
+        long long nanos = timeRuns(initial, iterations, [code](Value* slots) { return execute(code, slots); }, frame);
+        if (nanos < 0) {
+            cerr << "Division by zero or overflow in " << fn->name << endl;
+            return false;
+        }
+
+        // TAC is straight-line, so every run executes the whole body
+        long long executed = static_cast<long long>(fn->code.size() - 1) * iterations;
+        cout << "Executed " << fn->name << ": " << executed << " instructions in " << nanos / 1e6 << " ms ("
+            << (executed ? static_cast<double>(nanos) / executed : 0.0) << " ns/instruction)" << endl;
+        memcpy(bits.data(), frame.data(), bits.size() * sizeof(long long));
+        fn->layout.print(bits);
+        return true;
+    }
+};
+
+// Emits x86-64 System V assembly (GNU as, AT&T syntax) with linear-scan register allocation.
+// Each TAC function becomes "tac_<name>(...)" returning its last assigned variable; floats
+// live in general registers as raw doubles and only pass through %xmm0/%xmm1 to be operated on.
+class X86Emitter {
+private:
+    struct Interval {
+        string name;
+        int start;
+        int end;
+        int reg = -1;
+        int slot = -1;
+    };
+
+    // Caller-saved registers first; %rax, %rcx and %rdx stay free as scratch
+    const vector<string> registers = { "%r10", "%r11", "%rsi", "%rdi", "%r8", "%r9", "%rbx", "%r12", "%r13", "%r14", "%r15" };
+    const vector<string> argRegisters = { "%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9" };
+    const vector<string> floatArgRegisters = { "%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5", "%xmm6", "%xmm7" };
+
+    // Where each parameter arrives: a register name, or "" for the stack
+    struct ArgLayout {
+        vector<string> registers;
+        vector<int> stackIndex;
+        int registerCount = 0;
+        int stackCount = 0;
+    };
+
+    ostringstream out;
+    unordered_map<string, Interval> allocation;
+    int frameBase = 0;   // bytes between %rbp and the first spill slot
+
+    void line(const string& text) {
+        out << "    " << text << '\n';
+    }
+
+    ArgLayout layoutArgs(const vector<TACType>& types) {
+        ArgLayout layout;
+        size_t ints = 0, floats = 0;
+        for (TACType type : types) {
+            bool isFloat = type == TYPE_FLOAT;
+            string reg;
+            if (isFloat && floats < floatArgRegisters.size()) reg = floatArgRegisters[floats++];
+            else if (!isFloat && ints < argRegisters.size()) reg = argRegisters[ints++];
+            layout.registers.push_back(reg);
+            layout.stackIndex.push_back(reg.empty() ? layout.stackCount++ : -1);
+            if (!reg.empty()) layout.registerCount++;
+        }
+        return layout;
+    }
+
+    string slotAddress(int slot) {
+        return to_string(-(frameBase + 8 * (slot + 1))) + "(%rbp)";
+    }
+
+    string loc(const string& operand) {
+        const Interval& interval = allocation.at(operand);
+        return interval.reg >= 0 ? registers[interval.reg] : slotAddress(interval.slot);
+    }
+
+    // An operand usable as an ALU source; 64-bit constants go through 'scratch'
+    string source(const string& operand, const string& scratch, bool asFloat = false) {
+        if (!isNumberLiteral(operand)) return loc(operand);
+        long long value = literalBits(operand, asFloat);
+        if (value >= INT32_MIN && value <= INT32_MAX) return "$" + to_string(value);
+        line("movabsq $" + to_string(value) + ", " + scratch);
+        return scratch;
+    }
+
+    void loadXmm(const string& operand, const string& xmm) {
+        string from = source(operand, "%rax", true);
+        if (from[0] == '$') {
+            line("movq " + from + ", %rax");
+            from = "%rax";
+        }
+        line("movq " + from + ", " + xmm);
+    }
+
+    void move(const string& from, const string& to) {
+        if (from == to) return;
+        if (from[0] != '%' && from[0] != '$' && to[0] != '%') {
+            line("movq " + from + ", %rax");
+            line("movq %rax, " + to);
+        }
+        else {
+            line("movq " + from + ", " + to);
+        }
+    }
+
+    vector<Interval> buildIntervals(const TACFunction& fn, const string& result) {
+        unordered_map<string, int> index;
+        vector<Interval> intervals;
+
+        auto def = [&](const string& name, int position) {
+            auto it = index.find(name);
+            if (it != index.end()) {
+                intervals[it->second].end = position;
+                return;
+            }
+            index[name] = intervals.size();
+            intervals.push_back({ name, position, position });
+        };
+
+        // A name read before it is written is live (and zero) from entry
+        auto use = [&](const string& name, int position) {
+            if (isNumberLiteral(name)) return;
+            if (!index.count(name)) def(name, -1);
+            def(name, position);
+        };
+
+        for (const auto& param : fn.params) def(param, -1);
+        for (size_t i = 0; i < fn.body.size(); ++i) {
+            const TACInstr& instr = fn.body[i];
+            use(instr.lhs, i);
+            if (!instr.rhs.empty()) use(instr.rhs, i);
+            def(instr.dst, i);
+        }
+        if (!result.empty()) intervals[index[result]].end = fn.body.size();
+        return intervals;
+    }
+
+    // Poletto & Sarkar linear scan; returns the number of spill slots used
+    int allocate(vector<Interval>& intervals) {
+        stable_sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b) {
+            return a.start < b.start;
+            });
+
+        vector<int> freeRegisters;
+        for (int r = registers.size() - 1; r >= 0; --r) freeRegisters.push_back(r);
+        vector<Interval*> active;   // sorted by increasing end
+        int slots = 0;
+
+        for (auto& current : intervals) {
+            while (!active.empty() && active.front()->end < current.start) {
+                freeRegisters.push_back(active.front()->reg);
+                active.erase(active.begin());
+            }
+
+            if (freeRegisters.empty()) {
+                Interval* furthest = active.back();
+                if (furthest->end > current.end) {
+                    current.reg = furthest->reg;
+                    furthest->reg = -1;
+                    furthest->slot = slots++;
+                    active.pop_back();
+                }
+                else {
+                    current.slot = slots++;
+                    continue;
+                }
+            }
+            else {
+                current.reg = freeRegisters.back();
+                freeRegisters.pop_back();
+            }
+
+            auto at = upper_bound(active.begin(), active.end(), &current, [](const Interval* a, const Interval* b) {
+                return a->end < b->end;
+                });
+            active.insert(at, &current);
+        }
+        return slots;
+    }
+
+    void emitInstr(const TACInstr& instr) {
+        static const unordered_map<string, string> arithmetic = { { "+", "addq" }, { "-", "subq" }, { "*", "imulq" } };
+        static const unordered_map<string, string> conditions = {
+            { "==", "e" }, { "!=", "ne" }, { "<>", "ne" }, { "<", "l" }, { ">", "g" }, { "<=", "le" }, { ">=", "ge" },
+        };
+
+        string dst = loc(instr.dst);
+        if (instr.op.empty()) {
+            move(source(instr.lhs, "%rax", instr.type == TYPE_FLOAT), dst);
+            return;
+        }
+
+        if (instr.op == "itof") {
+            string from = source(instr.lhs, "%rax");
+            if (from[0] == '$') {
+                line("movq " + from + ", %rax");
+                from = "%rax";
+            }
+            line("cvtsi2sdq " + from + ", %xmm0");
+            line("movq %xmm0, " + dst);
+            return;
+        }
+        if (instr.op == "ftoi") {
+            loadXmm(instr.lhs, "%xmm0");
+            line("cvttsd2siq %xmm0, %rax");
+            move("%rax", dst);
+            return;
+        }
+
+        if (instr.type == TYPE_FLOAT) {
+            emitFloatInstr(instr, dst);
+            return;
+        }
+
+        if (instr.op == "/") {
+            string divisor = source(instr.rhs, "%rcx");
+            if (divisor[0] == '$') {
+                line("movq " + divisor + ", %rcx");
+                divisor = "%rcx";
+            }
+            move(source(instr.lhs, "%rax"), "%rax");
+            line("cqto");
+            line("idivq " + divisor);
+            move("%rax", dst);
+            return;
+        }
+
+        auto condition = conditions.find(instr.op);
+        if (condition != conditions.end()) {
+            string right = source(instr.rhs, "%rcx");
+            move(source(instr.lhs, "%rax"), "%rax");
+            line("cmpq " + right + ", %rax");
+            line("set" + condition->second + " %al");
+            line("movzbq %al, %rax");
+            move("%rax", dst);
+            return;
+        }
+
+        // Work directly in the destination register unless it holds the right operand
+        string right = source(instr.rhs, "%rcx");
+        string work = (dst[0] == '%' && dst != right) ? dst : "%rax";
+        move(source(instr.lhs, work), work);
+        if (instr.op == "*" && right[0] == '$') line("imulq " + right + ", " + work + ", " + work);
+        else line(arithmetic.at(instr.op) + " " + right + ", " + work);
+        move(work, dst);
+    }
+
+    // Scalar double ops; unordered compares (NaN) come out false except for !=
+    void emitFloatInstr(const TACInstr& instr, const string& dst) {
+        static const unordered_map<string, string> arithmetic = {
+            { "+", "addsd" }, { "-", "subsd" }, { "*", "mulsd" }, { "/", "divsd" },
+        };
+
+        loadXmm(instr.lhs, "%xmm0");
+        loadXmm(instr.rhs, "%xmm1");
+        auto op = arithmetic.find(instr.op);
+        if (op != arithmetic.end()) {
+            line(op->second + " %xmm1, %xmm0");
+            line("movq %xmm0, " + dst);
+            return;
+        }
+
+        if (instr.op == "<" || instr.op == "<=") {
+            line("ucomisd %xmm0, %xmm1");
+            line(instr.op == "<" ? "seta %al" : "setae %al");
+        }
+        else if (instr.op == ">" || instr.op == ">=") {
+            line("ucomisd %xmm1, %xmm0");
+            line(instr.op == ">" ? "seta %al" : "setae %al");
+        }
+        else if (instr.op == "==") {
+            line("ucomisd %xmm1, %xmm0");
+            line("sete %al");
+            line("setnp %cl");
+            line("andb %cl, %al");
+        }
+        else {
+            line("ucomisd %xmm1, %xmm0");
+            line("setne %al");
+            line("setp %cl");
+            line("orb %cl, %al");
+        }
+        line("movzbq %al, %rax");
+        move("%rax", dst);
+    }
+
+    void emitFunction(const TACFunction& fn) {
+        string result;
+        TACType returnType = TYPE_INT;
+        for (const auto& instr : fn.body) {
+            result = instr.dst;
+            returnType = resultType(instr);
+        }
+        ArgLayout args = layoutArgs(fn.paramTypes);
+
+        vector<Interval> intervals = buildIntervals(fn, result);
+        int spills = allocate(intervals);
+        allocation.clear();
+        for (const auto& interval : intervals) allocation[interval.name] = interval;
+
+        vector<string> saved;
+        for (const auto& interval : intervals) {
+            if (interval.reg >= 6 && find(saved.begin(), saved.end(), registers[interval.reg]) == saved.end()) {
+                saved.push_back(registers[interval.reg]);
+            }
+        }
+
+        // Frame: saved registers, then incoming register arguments, then spill slots
+        int regArgs = args.registerCount;
+        int frame = 8 * (regArgs + spills);
+        if ((8 * saved.size() + frame) % 16) frame += 8;
+        frameBase = 8 * (saved.size() + regArgs);
+
+        string symbol = "tac_" + fn.name;
+        out << "\n    .globl " << symbol << "\n    .type " << symbol << ", @function\n" << symbol << ":\n";
+        line("pushq %rbp");
+        line("movq %rsp, %rbp");
+        for (const auto& reg : saved) line("pushq " + reg);
+        if (frame) line("subq $" + to_string(frame) + ", %rsp");
+
+        vector<string> incoming;
+        for (size_t p = 0, spilled = 0; p < fn.params.size(); ++p) {
+            if (args.registers[p].empty()) {
+                incoming.push_back(to_string(16 + 8 * args.stackIndex[p]) + "(%rbp)");
+                continue;
+            }
+            string home = to_string(-8 * (int)(saved.size() + ++spilled)) + "(%rbp)";
+            line("movq " + args.registers[p] + ", " + home);
+            incoming.push_back(home);
+        }
+        for (size_t p = 0; p < fn.params.size(); ++p) {
+            move(incoming[p], loc(fn.params[p]));
+        }
+        for (const auto& interval : intervals) {
+            if (interval.start < 0 && find(fn.params.begin(), fn.params.end(), interval.name) == fn.params.end()) {
+                line("movq $0, " + loc(interval.name));
+            }
+        }
+
+        for (const auto& instr : fn.body) {
+            emitInstr(instr);
+        }
+
+        if (result.empty()) line("xorl %eax, %eax");
+        else if (returnType == TYPE_FLOAT) line("movq " + loc(result) + ", %xmm0");
+        else move(loc(result), "%rax");
+        if (!saved.empty()) line("leaq " + to_string(-8 * (int)saved.size()) + "(%rbp), %rsp");
+        else if (frame) line("movq %rbp, %rsp");
+        for (auto it = saved.rbegin(); it != saved.rend(); ++it) line("popq " + *it);
+        line("popq %rbp");
+        line("ret");
+        out << "    .size " << symbol << ", .-" << symbol << '\n';
+    }
+
+    // main(argc, argv): passes argv[1..] as the entry's arguments and prints its result
+    void emitMain(const TACFunction& entry) {
+        int count = entry.params.size();
+        ArgLayout args = layoutArgs(entry.paramTypes);
+        int area = 8 * count + (count % 2 ? 8 : 0);
+        bool floatResult = !entry.body.empty() && resultType(entry.body.back()) == TYPE_FLOAT;
+
+        out << "\n    .section .rodata\n.Lresult_format:\n    .string \"" << (floatResult ? "%g" : "%ld") << "\\n\"\n    .text\n"
+            << "    .globl main\n    .type main, @function\nmain:\n";
+        line("pushq %rbp");
+        line("movq %rsp, %rbp");
+        line("pushq %rbx");
+        line("pushq %r12");
+        if (area) line("subq $" + to_string(area) + ", %rsp");
+        line("movq %rsi, %rbx");
+        line("movslq %edi, %r12");
+
+        // Stack arguments sit at the bottom of the area, register arguments above them
+        vector<int> offsets;
+        for (int p = 0, inRegisters = 0; p < count; ++p) {
+            offsets.push_back(args.registers[p].empty() ? 8 * args.stackIndex[p] : 8 * (args.stackCount + inRegisters++));
+        }
+        for (int p = 0; p < count; ++p) {
+            bool isFloat = entry.paramTypes[p] == TYPE_FLOAT;
+            string skip = ".Lmissing_arg" + to_string(p);
+            line("xorl %eax, %eax");
+            line("cmpq $" + to_string(p + 1) + ", %r12");
+            line("jle " + skip);
+            line("movq " + to_string(8 * (p + 1)) + "(%rbx), %rdi");
+            line("xorl %esi, %esi");
+            if (isFloat) {
+                line("call strtod@PLT");
+                line("movq %xmm0, %rax");
+            }
+            else {
+                line("movl $10, %edx");
+                line("call strtol@PLT");
+            }
+            out << skip << ":\n";
+            line("movq %rax, " + to_string(offsets[p]) + "(%rsp)");
+        }
+        for (int p = 0; p < count; ++p) {
+            if (!args.registers[p].empty()) line("movq " + to_string(offsets[p]) + "(%rsp), " + args.registers[p]);
+        }
+        line("call tac_" + entry.name);
+
+        line("leaq .Lresult_format(%rip), %rdi");
+        if (floatResult) {
+            line("movl $1, %eax");
+        }
+        else {
+            line("movq %rax, %rsi");
+            line("xorl %eax, %eax");
+        }
+        line("call printf@PLT");
+        line("xorl %eax, %eax");
+        line("leaq -16(%rbp), %rsp");
+        line("popq %r12");
+        line("popq %rbx");
+        line("popq %rbp");
+        line("ret");
+        out << "    .size main, .-main\n";
+    }
+
+public:
+    bool emitProgram(const vector<TACInstr>& instrs, const string& entry, bool withMain, const string& filename) {
+        vector<TACFunction> functions = splitFunctions(instrs);
+        const TACFunction* entryFunction = nullptr;
+
+        out.str("");
+        out << "    .text\n";
+        for (const auto& fn : functions) {
+            for (const auto& instr : fn.body) {
+                if (isMalformed(instr)) {
+                    cerr << "Malformed TAC in " << fn.name << ": " << instr.dst << " := " << instr.lhs << endl;
+                    return false;
+                }
+            }
+            if (fn.name.empty()) {
+                cerr << "Cannot emit TAC outside a function" << endl;
+                return false;
+            }
+            emitFunction(fn);
+            if (!entryFunction && (entry.empty() || fn.name == entry)) entryFunction = &fn;
+        }
+
+        if (withMain) {
+            if (!entryFunction) {
+                cerr << "No TAC function named '" << entry << "'" << endl;
+                return false;
+            }
+            emitMain(*entryFunction);
+        }
+        out << "    .section .note.GNU-stack,\"\",@progbits\n";
+
+        ofstream file(filename);
+        if (!file.is_open()) {
+            cerr << "Unable to open " << filename << " for writing" << endl;
+            return false;
+        }
+        file << out.str();
+        return true;
+    }
+};
+
+#if defined(__x86_64__) && defined(__unix__)
+// Translates a TAC function straight to x86-64 machine code and runs it in-process. Every
+// operand lives in a FrameLayout slot addressed off %rdi, so the interpreter's frame is
+// reused as is. The buffer is writable while it is filled and executable afterwards, never both.
+class TACJit {
+private:
+    typedef int (*Entry)(long long* frame);   // returns 1 on division by zero or overflow
+
+    vector<unsigned char> code;
+    FrameLayout layout;
+    string name;
+    size_t instrCount = 0;
+    void* buffer = nullptr;
+    size_t bufferSize = 0;
+
+    enum { RAX = 0, RCX = 1, RDX = 2, DIVIDE = 7 };
+
+    void bytes(initializer_list<unsigned char> list) { code.insert(code.end(), list); }
+
+    void imm32(int value) {
+        for (int i = 0; i < 4; ++i) code.push_back((value >> (8 * i)) & 0xFF);
+    }
+
+    // <opcode> with ModRM [rdi + disp32]; 'reg' is the register or opcode extension
+    void memOp(initializer_list<unsigned char> opcode, int reg, int slot) {
+        bytes(opcode);
+        code.push_back(0x80 | (reg << 3) | 7);
+        imm32(slot * 8);
+    }
+
+    void loadRax(int slot) { memOp({ 0x48, 0x8B }, RAX, slot); }
+    void storeRax(int slot) { memOp({ 0x48, 0x89 }, RAX, slot); }
+    void loadXmm(int xmm, int slot) { memOp({ 0xF2, 0x0F, 0x10 }, xmm, slot); }
+    void storeXmm0(int slot) { memOp({ 0xF2, 0x0F, 0x11 }, 0, slot); }
+    void storeFlag(int slot) {
+        bytes({ 0x0F, 0xB6, 0xC0 });    // movzbl %al, %eax
+        storeRax(slot);
+    }
+
+    bool emitInstr(const TACInstr& instr) {
+        static const unordered_map<string, unsigned char> intConditions = {
+            { "==", 0x94 }, { "!=", 0x95 }, { "<>", 0x95 }, { "<", 0x9C }, { ">", 0x9F }, { "<=", 0x9E }, { ">=", 0x9D },
+        };
+        static const unordered_map<string, unsigned char> floatArithmetic = {
+            { "+", 0x58 }, { "-", 0x5C }, { "*", 0x59 }, { "/", 0x5E },
+        };
+
+        bool asFloat = readsFloat(instr);
+        int a = layout.slotOf(instr.lhs, asFloat);
+        int b = instr.rhs.empty() ? 0 : layout.slotOf(instr.rhs, asFloat);
+        int dst = layout.define(instr);
+
+        if (instr.op.empty()) {
+            loadRax(a);
+            storeRax(dst);
+        }
+        else if (instr.op == "itof") {
+            memOp({ 0xF2, 0x48, 0x0F, 0x2A }, 0, a);    // cvtsi2sdq
+            storeXmm0(dst);
+        }
+        else if (instr.op == "ftoi") {
+            memOp({ 0xF2, 0x48, 0x0F, 0x2C }, RAX, a);  // cvttsd2siq
+            storeRax(dst);
+        }
+        else if (instr.type == TYPE_FLOAT) {
+            loadXmm(0, a);
+            loadXmm(1, b);
+            auto op = floatArithmetic.find(instr.op);
+            if (op != floatArithmetic.end()) {
+                bytes({ 0xF2, 0x0F, op->second, 0xC1 });
+                storeXmm0(dst);
+                return true;
+            }
+
+            // Same NaN handling as X86Emitter::emitFloatInstr
+            if (instr.op == "<" || instr.op == "<=") {
+                bytes({ 0x66, 0x0F, 0x2E, 0xC8 });      // ucomisd %xmm0, %xmm1
+                bytes({ 0x0F, static_cast<unsigned char>(instr.op == "<" ? 0x97 : 0x93), 0xC0 });
+            }
+            else if (instr.op == ">" || instr.op == ">=") {
+                bytes({ 0x66, 0x0F, 0x2E, 0xC1 });      // ucomisd %xmm1, %xmm0
+                bytes({ 0x0F, static_cast<unsigned char>(instr.op == ">" ? 0x97 : 0x93), 0xC0 });
+            }
+            else if (instr.op == "==") {
+                bytes({ 0x66, 0x0F, 0x2E, 0xC1, 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8 });  // sete, setnp, andb
+            }
+            else if (intConditions.count(instr.op)) {
+                bytes({ 0x66, 0x0F, 0x2E, 0xC1, 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8 });  // setne, setp, orb
+            }
+            else {
+                return false;
+            }
+            storeFlag(dst);
+        }
+        else if (instr.op == "/") {
+            // Zero and INT64_MIN / -1 would raise SIGFPE in idivq; both return 1 instead
+            memOp({ 0x48, 0x83 }, DIVIDE, b);           // cmpq $0, divisor
+            code.push_back(0x00);
+            bytes({ 0x75, 0x06, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xC3 });  // jne over "movl $1, %eax; ret"
+            memOp({ 0x48, 0x83 }, DIVIDE, b);           // cmpq $-1, divisor
+            code.push_back(0xFF);
+            bytes({ 0x75, 0x12 });                      // jne over the next 18 bytes
+            loadRax(a);
+            bytes({ 0x48, 0xF7, 0xD8 });                // negq %rax overflows only for INT64_MIN
+            bytes({ 0x71, 0x06, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xC3 });  // jno over "movl $1, %eax; ret"
+            loadRax(a);
+            bytes({ 0x48, 0x99 });                      // cqto
+            memOp({ 0x48, 0xF7 }, DIVIDE, b);           // idivq
+            storeRax(dst);
+        }
+        else if (instr.op == "+" || instr.op == "-" || instr.op == "*") {
+            loadRax(a);
+            if (instr.op == "+") memOp({ 0x48, 0x03 }, RAX, b);
+            else if (instr.op == "-") memOp({ 0x48, 0x2B }, RAX, b);
+            else memOp({ 0x48, 0x0F, 0xAF }, RAX, b);
+            storeRax(dst);
+        }
+        else {
+            auto condition = intConditions.find(instr.op);
+            if (condition == intConditions.end()) return false;
+            loadRax(a);
+            memOp({ 0x48, 0x3B }, RAX, b);              // cmpq
+            bytes({ 0x0F, condition->second, 0xC0 });
+            storeFlag(dst);
+        }
+        return true;
+    }
+
+    void release() {
+        if (buffer) munmap(buffer, bufferSize);
+        buffer = nullptr;
+    }
+
+public:
+    TACJit() {}
+    TACJit(const TACJit&) = delete;
+    TACJit& operator=(const TACJit&) = delete;
+    ~TACJit() { release(); }
+
+    // Compiles 'entry' (the first function when empty) into executable memory
+    bool compile(const vector<TACInstr>& instrs, const string& entry) {
+        auto begin = chrono::steady_clock::now();
+        vector<TACFunction> functions = splitFunctions(instrs);
+        const TACFunction* fn = nullptr;
+        for (const auto& f : functions) {
+            if (entry.empty() || f.name == entry) {
+                fn = &f;
+                break;
+            }
+        }
+        if (!fn) {
+            cerr << "No TAC function named '" << entry << "'" << endl;
+            return false;
+        }
+
+        release();
+        code.clear();
+        layout = FrameLayout();
+        name = fn->name;
+        instrCount = fn->body.size();
+        layout.addParams(*fn);
+        for (const auto& instr : fn->body) {
+            if (isMalformed(instr)) {
+                cerr << "Malformed TAC in " << name << ": " << instr.dst << " := " << instr.lhs << endl;
+                return false;
+            }
+            if (!emitInstr(instr)) {
+                cerr << "Unknown TAC operator '" << instr.op << "'" << endl;
+                return false;
+            }
+        }
+        bytes({ 0x31, 0xC0, 0xC3 });                    // xorl %eax, %eax; ret
+
+        long page = sysconf(_SC_PAGESIZE);
+        bufferSize = (code.size() + page - 1) / page * page;
+        buffer = mmap(nullptr, bufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer == MAP_FAILED) {
+            buffer = nullptr;
+            cerr << "Unable to map memory for the JIT" << endl;
+            return false;
+        }
+        memcpy(buffer, code.data(), code.size());
+        if (mprotect(buffer, bufferSize, PROT_READ | PROT_EXEC) != 0) {
+            release();
+            cerr << "Unable to make JIT code executable" << endl;
+            return false;
+        }
+
+        long long nanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count();
+        cout << "JIT compiled " << name << ": " << instrCount << " instructions to " << code.size() << " bytes in "
+            << nanos / 1e3 << " us" << endl;
+        return true;
+    }
+
+    // Calls the compiled function and prints its variables
+    bool run(const vector<string>& args, long long iterations) {
+        if (!buffer) return false;
+        Entry function = reinterpret_cast<Entry>(buffer);
+        const vector<long long> initial = layout.frameFor(args);
+
+        vector<long long> frame;
+        long long nanos = timeRuns(initial, iterations, [function](long long* slots) { return function(slots) == 0; }, frame);
+        if (nanos < 0) {
+            cerr << "Division by zero or overflow in " << name << endl;
+            return false;
+        }
+
+        long long executed = static_cast<long long>(instrCount) * iterations;
+        cout << "Executed " << name << " (JIT): " << executed << " instructions in " << nanos / 1e6 << " ms ("
+            << (executed ? static_cast<double>(nanos) / executed : 0.0) << " ns/instruction)" << endl;
+        layout.print(frame);
+        return true;
+    }
+};
+#endif
+
+vector<TACInstr> loadTACFile(const string& filename) {
+    vector<TACInstr> instrs;
+    ifstream file(filename);
+    if (!file.is_open()) {
+        cerr << "Error opening file: " << filename << endl;
+        return instrs;
+    }
+
+    string line;
+    while (getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) instrs.push_back(parseTACLine(line));
+    }
+    return instrs;
+}
+
+// Compiles and runs the entry function in-process
+bool runJit(const vector<TACInstr>& instrs, const string& entry, const vector<string>& args, long long iterations) {
+#if defined(__x86_64__) && defined(__unix__)
+    TACJit jit;
+    return jit.compile(instrs, entry) && jit.run(args, iterations);
+#else
+    cerr << "The JIT needs x86-64 Linux" << endl;
+    return false;
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    bool useCache = true;
+    bool runTAC = false;
+    bool jitTAC = false;
+    bool asmMain = true;
+    bool serialLoad = false;
+    unsigned jobs = 1;      // the parallel loader is opt-in until it is shown to win
+    string perfFile, traceFile, runFile, entry, asmFile;
+    vector<string> args;
+    long long iterations = 1;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--no-cache") useCache = false;
+        else if (arg == "--run") runTAC = true;
+        else if (arg == "--jit") jitTAC = true;
+        else if (arg == "--asm-no-main") asmMain = false;
+        else if (arg == "--serial-load") serialLoad = true;
+        else if (arg == "--jobs" && i + 1 < argc) {
+            int count = atoi(argv[++i]);
+            jobs = count > 0 ? count : max(1u, thread::hardware_concurrency());   // 0: every core
+        }
+        else if (arg == "--emit-asm" && i + 1 < argc) asmFile = argv[++i];
+        else if (arg == "--perf" && i + 1 < argc) perfFile = argv[++i];
+        else if (arg == "--trace" && i + 1 < argc) traceFile = argv[++i];
+        else if (arg == "--run-file" && i + 1 < argc) runFile = argv[++i];
+        else if (arg == "--entry" && i + 1 < argc) entry = argv[++i];
+        else if (arg == "--iterations" && i + 1 < argc) iterations = max(1LL, atoll(argv[++i]));
+        else if (arg == "--args" && i + 1 < argc) {
+            stringstream list(argv[++i]);
+            string value;
+            while (getline(list, value, ',')) args.push_back(value);
+        }
+    }
+
+    // Interpret (or compile) an existing TAC file without regenerating it
+    if (!runFile.empty()) {
+        vector<TACInstr> instrs = loadTACFile(runFile);
+        if (instrs.empty()) return 1;
+        if (!asmFile.empty()) {
+            X86Emitter emitter;
+            if (!emitter.emitProgram(instrs, entry, asmMain, asmFile)) return 1;
+            cout << "Assembly saved to " << asmFile << endl;
+        }
+
+        if (jitTAC) return runJit(instrs, entry, args, iterations) ? 0 : 1;
+
+        TACInterpreter interpreter;
+        if (!interpreter.load(instrs)) return 1;
+        return interpreter.run(entry, args, iterations) ? 0 : 1;
+    }
+    if (!perfFile.empty() || !traceFile.empty()) {
+        perfEpoch = chrono::steady_clock::now();
+        perfEnabled = true;
+    }
+
     // Build parse tree from file
-    TreeNode* parseTree = buildTreeFromFile("tree.txt");
+    TreeNode* parseTree;
+    {
+        PhaseTimer phase("buildTreeFromFile");
+        parseTree = serialLoad ? buildTreeFromFile("tree.txt") : buildTreeFromFileParallel("tree.txt", jobs);
+        phase.setItems(nodesAllocated, "nodes");
+    }
     if (!parseTree) {
         cerr << "Failed to build parse tree" << endl;
         return 1;
@@ -181,24 +1932,83 @@ int main() {
     // Generate TAC from parse tree
     TACGenerator tacGen;
 
-    // Start processing from the CompStmt node which contains the actual code
-    for (auto child : parseTree->children) {
-        if (child->type == "Function") {
-            for (auto funcChild : child->children) {
-                if (funcChild->type == "CompStmt") {
-                    processNode(funcChild, tacGen);
-                    break;
-                }
+    TACCache cache("tac.cache");
+    if (useCache) {
+        PhaseTimer phase("loadTACCache");
+        cache.load();
+        phase.setItems(cache.size(), "functions");
+    }
+
+    // Lower every function, reusing cached TAC for unchanged subtrees
+    {
+        PhaseTimer phase("processNode");
+        for (auto child : parseTree->children) {
+            if (child->type != "Function") continue;
+
+            if (!useCache) {
+                lowerFunction(child, tacGen);
+                continue;
             }
-            break;
+
+            // Everything but lowerFunction() itself counts as cache overhead
+            auto begin = chrono::steady_clock::now();
+            uint64_t key = fnvOffset;
+            fingerprintTree(child, key);
+            bool hit = cache.emit(key, tacGen);
+            cache.overheadNanos += nanosSince(begin);
+            if (hit) continue;
+
+            size_t start = tacGen.size();
+            auto lowerBegin = chrono::steady_clock::now();
+            lowerFunction(child, tacGen);
+            long long lowerNanos = nanosSince(lowerBegin);
+
+            auto storeBegin = chrono::steady_clock::now();
+            cache.store(key, tacGen, start, lowerNanos);
+            cache.overheadNanos += nanosSince(storeBegin);
+        }
+        phase.setItems(tacGen.size(), "lines");
+    }
+
+    if (useCache) {
+        {
+            PhaseTimer phase("saveTACCache");
+            cache.save();
+            phase.setItems(cache.usedSize(), "functions");
         }
+        cout << "Function cache: " << cache.hits << " hits, " << cache.misses << " misses, "
+            << (cache.avoidedNanos - cache.overheadNanos) / 1e6 << " ms saved (" << cache.avoidedNanos / 1e6
+            << " ms of lowering avoided, " << cache.overheadNanos / 1e6 << " ms of cache overhead)" << endl;
     }
 
     // Output results
     cout << "Generated Three Address Code:\n";
-    tacGen.print();
-    tacGen.saveToFile("result.tac");
+    {
+        PhaseTimer phase("print");
+        tacGen.print();
+        phase.setItems(tacGen.size(), "lines");
+    }
+    {
+        PhaseTimer phase("saveToFile");
+        tacGen.saveToFile("result.tac");
+        phase.setItems(tacGen.size(), "lines");
+    }
     cout << "TAC saved to result.tac" << endl;
 
+    if (!asmFile.empty()) {
+        X86Emitter emitter;
+        if (!emitter.emitProgram(tacGen.instructions(), entry, asmMain, asmFile)) return 1;
+        cout << "Assembly saved to " << asmFile << endl;
+    }
+
+    if (runTAC) {
+        TACInterpreter interpreter;
+        if (!interpreter.load(tacGen.instructions()) || !interpreter.run(entry, args, iterations)) return 1;
+    }
+    if (jitTAC && !runJit(tacGen.instructions(), entry, args, iterations)) return 1;
+
+    if (!perfFile.empty()) writePerfJson(perfFile, "tacgen");
+    if (!traceFile.empty()) writeTraceJson(traceFile, "tacgen");
+
     return 0;
 }
\ No newline at end of file